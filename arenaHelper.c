@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arenaHelper.h"
+#include "numaHelper.h"
+
+// the block header is padded to the alignment, the memory of a block starts right after it
+#define ARENA_HEADER_SIZE ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+static ArenaBlock *allocateArenaBlock(size_t size)
+{
+    void *block = NULL;
+    if (allocateAligned(&block, ARENA_ALIGNMENT, ARENA_HEADER_SIZE + size) != 0)
+        block = NULL;
+    checkMalloc(block, "arena block");
+    ((ArenaBlock *)block)->next = NULL;
+    ((ArenaBlock *)block)->size = size;
+    ((ArenaBlock *)block)->used = 0;
+    return (ArenaBlock *)block;
+}
+
+void initializeArena(Arena *arena, size_t blockSize)
+{
+    arena->blocks = NULL;
+    arena->blockSize = blockSize;
+}
+
+void *arenaAllocate(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if (arena->blocks == NULL || arena->blocks->size - arena->blocks->used < size)
+    {
+        ArenaBlock *block = allocateArenaBlock(size > arena->blockSize ? size : arena->blockSize);
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    char *memory = (char *)arena->blocks + ARENA_HEADER_SIZE + arena->blocks->used;
+    arena->blocks->used += size;
+    return memory;
+}
+
+void resetArena(Arena *arena)
+{
+    if (arena->blocks == NULL)
+        return;
+    if (arena->blocks->next != NULL)
+    {
+        size_t totalSize = 0;
+        for (ArenaBlock *block = arena->blocks; block != NULL; block = block->next)
+            totalSize += block->size;
+        freeArena(arena);
+        arena->blocks = allocateArenaBlock(totalSize);
+    }
+    arena->blocks->used = 0;
+}
+
+void freeArena(Arena *arena)
+{
+    while (arena->blocks != NULL)
+    {
+        ArenaBlock *next = arena->blocks->next;
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+}
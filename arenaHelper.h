@@ -0,0 +1,55 @@
+#pragma once
+#include "helper.h"
+
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define ARENA_ALIGNMENT 64 // a cache line, and a multiple of the row alignment of colors matrices
+
+struct ArenaBlockStruct
+{
+    struct ArenaBlockStruct *next;
+    size_t size;
+    size_t used;
+};
+typedef struct ArenaBlockStruct ArenaBlock;
+
+/*
+ * An arena hands out memory from large blocks and releases all of it at once. Pointers stay valid until
+ * the arena is reset, since a full block is never moved, a new block is chained in front of it.
+ * Resetting merges the blocks into one block of their total size, so an arena reset once per picture
+ * grows to the largest picture and then serves every picture from one block without calling malloc.
+ */
+struct ArenaStruct
+{
+    ArenaBlock *blocks; // the current block first
+    size_t blockSize;
+};
+
+/*
+ * This function initializes an empty arena
+ * @param arena: the arena
+ * @param blockSize: the smallest block size in bytes
+ * @return: void
+ */
+void initializeArena(Arena *arena, size_t blockSize);
+
+/*
+ * This function allocates memory from an arena, aligned to ARENA_ALIGNMENT bytes
+ * @param arena: the arena
+ * @param size: the size in bytes
+ * @return: the memory, valid until the arena is reset or freed
+ */
+void *arenaAllocate(Arena *arena, size_t size);
+
+/*
+ * This function releases all memory allocated from an arena for reuse, keeping one block of the total size
+ * @param arena: the arena
+ * @return: void
+ */
+void resetArena(Arena *arena);
+
+/*
+ * This function frees the blocks of an arena
+ * @param arena: the arena
+ * @return: void
+ */
+void freeArena(Arena *arena);
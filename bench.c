@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "helper.h"
+#include "cpuHelper.h"
+
+#define DEFAULT_BENCH_FILE "bench.csv"
+#define DEFAULT_EXECUTABLE "./final_project_exe"
+#define DEFAULT_MPIEXEC "mpiexec"
+#define MAX_LIST_LENGTH 64
+#define MAX_COMMAND_LENGTH 4096
+
+struct BenchOptionsStruct
+{
+    int endToEnd;
+    const char *csvFile;
+    const char *label;
+    int warmup;
+    int repetitions;
+    double matchingThreshold;
+    unsigned int seed;
+    int numberOfBackends;
+    const char *backends[MAX_LIST_LENGTH];
+    int numberOfPictureSizes;
+    int pictureSizes[MAX_LIST_LENGTH];
+    int numberOfObjectSizes;
+    int objectSizes[MAX_LIST_LENGTH];
+    // end-to-end mode
+    const char *executable;
+    const char *mpiexec;
+    const char *inputFile;
+    int numberOfRankCounts;
+    int rankCounts[MAX_LIST_LENGTH];
+    int numberOfThreadCounts;
+    int threadCounts[MAX_LIST_LENGTH];
+};
+typedef struct BenchOptionsStruct BenchOptions;
+
+static void fail(const char *message, const char *detail)
+{
+    fprintf(stderr, "Error: %s %s\n", message, detail);
+    exit(1);
+}
+
+static int parseIntList(const char *text, int *values)
+{
+    int count = 0;
+    for (const char *p = text; p != NULL && count < MAX_LIST_LENGTH; p = strchr(p, ','))
+    {
+        if (*p == ',')
+            p++;
+        values[count++] = atoi(p);
+    }
+    return count;
+}
+
+static int parseNameList(char *text, const char **names)
+{
+    int count = 0;
+    for (char *name = strtok(text, ","); name != NULL && count < MAX_LIST_LENGTH; name = strtok(NULL, ","))
+        names[count++] = name;
+    return count;
+}
+
+static void parseBenchOptions(int argc, char *argv[], BenchOptions *options)
+{
+    memset(options, 0, sizeof(*options));
+    options->csvFile = DEFAULT_BENCH_FILE;
+    options->label = "";
+    options->warmup = 1;
+    options->repetitions = 5;
+    // random pictures and objects practically never match at this threshold, so every position is evaluated
+    options->matchingThreshold = 0.1;
+    options->seed = 1;
+    options->numberOfPictureSizes = parseIntList("100,200,400", options->pictureSizes);
+    options->numberOfObjectSizes = parseIntList("10,20,40,100", options->objectSizes);
+    options->executable = DEFAULT_EXECUTABLE;
+    options->mpiexec = DEFAULT_MPIEXEC;
+    options->inputFile = INPUT_FILE;
+    options->numberOfRankCounts = parseIntList("2,4", options->rankCounts);
+    options->numberOfThreadCounts = parseIntList("1,2,4", options->threadCounts);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--e2e") == 0)
+        {
+            options->endToEnd = 1;
+            continue;
+        }
+        if (i + 1 >= argc)
+            fail("missing value for option", argv[i]);
+        if (strcmp(argv[i], "--csv") == 0)
+            options->csvFile = argv[++i];
+        else if (strcmp(argv[i], "--label") == 0)
+            options->label = argv[++i];
+        else if (strcmp(argv[i], "--warmup") == 0)
+            options->warmup = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--repetitions") == 0)
+            options->repetitions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0)
+            options->matchingThreshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0)
+            options->seed = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--backends") == 0)
+            options->numberOfBackends = parseNameList(argv[++i], options->backends);
+        else if (strcmp(argv[i], "--picture-sizes") == 0)
+            options->numberOfPictureSizes = parseIntList(argv[++i], options->pictureSizes);
+        else if (strcmp(argv[i], "--object-sizes") == 0)
+            options->numberOfObjectSizes = parseIntList(argv[++i], options->objectSizes);
+        else if (strcmp(argv[i], "--executable") == 0)
+            options->executable = argv[++i];
+        else if (strcmp(argv[i], "--mpiexec") == 0)
+            options->mpiexec = argv[++i];
+        else if (strcmp(argv[i], "--input") == 0)
+            options->inputFile = argv[++i];
+        else if (strcmp(argv[i], "--ranks") == 0)
+            options->numberOfRankCounts = parseIntList(argv[++i], options->rankCounts);
+        else if (strcmp(argv[i], "--threads") == 0)
+            options->numberOfThreadCounts = parseIntList(argv[++i], options->threadCounts);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--backends a,b] [--picture-sizes a,b] [--object-sizes a,b] [--threshold t]\n"
+                            "       [--warmup n] [--repetitions n] [--seed s] [--csv file] [--label text]\n"
+                            "       %s --e2e [--backends a,b] [--ranks a,b] [--threads a,b] [--input file]\n"
+                            "       [--executable file] [--mpiexec command] [--repetitions n] [--csv file] [--label text]\n",
+                    argv[0], argv[0]);
+            exit(1);
+        }
+    }
+
+    // all CPU backends by default, the GPU backend has to be asked for
+    if (options->numberOfBackends == 0)
+        for (int i = 0; i < numberOfMatchingBackends; i++)
+            if (strcmp(matchingBackends[i].name, "gpu") != 0)
+                options->backends[options->numberOfBackends++] = matchingBackends[i].name;
+    for (int i = 0; i < options->numberOfBackends; i++)
+        if (findMatchingBackend(options->backends[i]) == NULL)
+            fail("unknown backend", options->backends[i]);
+    if (options->repetitions < 1)
+        fail("invalid number of", "repetitions");
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * This function opens the CSV file for appending, so results of several builds end up in one file
+ * @return: the file pointer
+ */
+static FILE *openCsv(const char *csvFile, const char *header)
+{
+    FILE *fp = fopen(csvFile, "a+");
+    if (fp == NULL)
+        fail("opening", csvFile);
+    fseek(fp, 0, SEEK_END);
+    if (ftell(fp) == 0)
+        fprintf(fp, "%s\n", header);
+    return fp;
+}
+
+static void fillRandomColors(int *colors, int numberOfColors)
+{
+    for (int i = 0; i < numberOfColors; i++)
+        colors[i] = 1 + rand() % 100;
+}
+
+static void benchKernels(BenchOptions *options)
+{
+    FILE *csv = openCsv(options->csvFile, "label,backend,picture_dimension,object_dimension,threshold,repetitions,median_seconds,min_seconds,positions_per_second,comparisons_per_second");
+    double *times = (double *)malloc(options->repetitions * sizeof(double));
+    srand(options->seed);
+
+    printf("%-8s %8s %8s %12s %16s %16s\n", "backend", "picture", "object", "median[s]", "positions/s", "comparisons/s");
+    for (int p = 0; p < options->numberOfPictureSizes; p++)
+        for (int o = 0; o < options->numberOfObjectSizes; o++)
+        {
+            Picture picture;
+            Object object;
+            picture.ID = object.ID = 1;
+            int pictureDimension = options->pictureSizes[p];
+            int objectDimension = options->objectSizes[o];
+            if (objectDimension > pictureDimension)
+                continue;
+            allocatePicture(&picture, pictureDimension, pictureDimension);
+            allocateObject(&object, objectDimension, objectDimension);
+            for (int i = 0; i < pictureDimension; i++)
+                fillRandomColors(picture.colorsMatrix + i * picture.pitch, pictureDimension);
+            for (int i = 0; i < objectDimension; i++)
+                fillRandomColors(object.subColorsMatrix + i * object.pitch, objectDimension);
+
+            double positions = (double)(pictureDimension - objectDimension + 1) * (pictureDimension - objectDimension + 1);
+            double comparisons = positions * objectDimension * objectDimension;
+
+            for (int b = 0; b < options->numberOfBackends; b++)
+            {
+                MatchingFunction matchingFunction = findMatchingBackend(options->backends[b])->function;
+                int upperLeftCorner = NOT_FOUND;
+
+                for (int r = 0; r < options->warmup; r++)
+                    matchingFunction(&picture, &object, &upperLeftCorner, options->matchingThreshold);
+                for (int r = 0; r < options->repetitions; r++)
+                {
+                    upperLeftCorner = NOT_FOUND;
+                    double startTime = omp_get_wtime();
+                    matchingFunction(&picture, &object, &upperLeftCorner, options->matchingThreshold);
+                    times[r] = omp_get_wtime() - startTime;
+                }
+                qsort(times, options->repetitions, sizeof(double), compareDoubles);
+                double median = times[options->repetitions / 2];
+
+                // rates are nominal work over time, pruning backends skip part of it
+                printf("%-8s %8d %8d %12.6f %16.4g %16.4g\n", options->backends[b], pictureDimension, objectDimension, median, positions / median, comparisons / median);
+                fprintf(csv, "%s,%s,%d,%d,%g,%d,%.9f,%.9f,%.6g,%.6g\n", options->label, options->backends[b], pictureDimension, objectDimension,
+                        options->matchingThreshold, options->repetitions, median, times[0], positions / median, comparisons / median);
+                fflush(csv);
+            }
+
+            free(picture.colorsMatrix);
+            free(object.subColorsMatrix);
+        }
+
+    free(times);
+    fclose(csv);
+}
+
+/*
+ * This function runs the MPI pipeline once
+ * @return: the time reported by the pipeline, or -1 if it failed
+ */
+static double runPipeline(BenchOptions *options, const char *backend, int numRanks, int numThreads, double *wallTime)
+{
+    char command[MAX_COMMAND_LENGTH];
+    char line[MAX_COMMAND_LENGTH];
+    double reportedTime = -1;
+
+    snprintf(command, sizeof(command), "OMP_NUM_THREADS=%d %s -np %d %s --input %s --backend %s --threads %d",
+             numThreads, options->mpiexec, numRanks, options->executable, options->inputFile, backend, numThreads);
+    double startTime = omp_get_wtime();
+    FILE *pipe = popen(command, "r");
+    if (pipe == NULL)
+        fail("running", command);
+    while (fgets(line, sizeof(line), pipe) != NULL)
+        sscanf(line, "Time taken: %lf", &reportedTime);
+    if (pclose(pipe) != 0)
+        reportedTime = -1;
+    *wallTime = omp_get_wtime() - startTime;
+    return reportedTime;
+}
+
+static void benchPipeline(BenchOptions *options)
+{
+    FILE *csv = openCsv(options->csvFile, "label,backend,input,ranks,threads,repetitions,median_seconds,min_seconds,median_wall_seconds");
+    double *times = (double *)malloc(options->repetitions * sizeof(double));
+    double *wallTimes = (double *)malloc(options->repetitions * sizeof(double));
+
+    printf("%-8s %6s %8s %12s %12s\n", "backend", "ranks", "threads", "median[s]", "wall[s]");
+    for (int b = 0; b < options->numberOfBackends; b++)
+        for (int n = 0; n < options->numberOfRankCounts; n++)
+            for (int t = 0; t < options->numberOfThreadCounts; t++)
+            {
+                double wallTime;
+                int numRanks = options->rankCounts[n];
+                int numThreads = options->threadCounts[t];
+
+                for (int r = 0; r < options->warmup; r++)
+                    runPipeline(options, options->backends[b], numRanks, numThreads, &wallTime);
+                for (int r = 0; r < options->repetitions; r++)
+                {
+                    times[r] = runPipeline(options, options->backends[b], numRanks, numThreads, &wallTimes[r]);
+                    if (times[r] < 0)
+                        fail("pipeline run failed for backend", options->backends[b]);
+                }
+                qsort(times, options->repetitions, sizeof(double), compareDoubles);
+                qsort(wallTimes, options->repetitions, sizeof(double), compareDoubles);
+
+                printf("%-8s %6d %8d %12.6f %12.6f\n", options->backends[b], numRanks, numThreads, times[options->repetitions / 2], wallTimes[options->repetitions / 2]);
+                fprintf(csv, "%s,%s,%s,%d,%d,%d,%.9f,%.9f,%.9f\n", options->label, options->backends[b], options->inputFile, numRanks, numThreads,
+                        options->repetitions, times[options->repetitions / 2], times[0], wallTimes[options->repetitions / 2]);
+                fflush(csv);
+            }
+
+    free(times);
+    free(wallTimes);
+    fclose(csv);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    parseBenchOptions(argc, argv, &options);
+
+    if (options.endToEnd)
+        benchPipeline(&options);
+    else
+        benchKernels(&options);
+    return 0;
+}
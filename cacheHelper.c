@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/stat.h>
+#include "cacheHelper.h"
+
+static const unsigned long long keySeeds[CACHE_KEY_WORDS] = {0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL};
+
+/*
+ * Multiply and xor-shift mixing of one 64 bit word into a hash, two seeds give two independent halves of the key
+ */
+static inline unsigned long long mixWord(unsigned long long hash, unsigned long long word)
+{
+    hash ^= word * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 31)) * 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 29);
+}
+
+static void hashInts(CacheKey *key, const int *data, int count)
+{
+    for (int k = 0; k < CACHE_KEY_WORDS; k++)
+    {
+        unsigned long long hash = key->words[k];
+        int i = 0;
+        for (; i + 1 < count; i += 2)
+            hash = mixWord(hash, (unsigned int)data[i] | (unsigned long long)(unsigned int)data[i + 1] << 32);
+        if (i < count)
+            hash = mixWord(hash, (unsigned int)data[i]);
+        key->words[k] = hash;
+    }
+}
+
+/*
+ * This function hashes the size and the colors of a matrix without its row padding
+ */
+static void hashColorsMatrix(CacheKey *key, const int *colorsMatrix, int width, int height, int pitch)
+{
+    int size[2] = {width, height};
+    hashInts(key, size, 2);
+    for (int i = 0; i < height; i++)
+        hashInts(key, colorsMatrix + (size_t)i * pitch, width);
+}
+
+void initializeKey(CacheKey *key)
+{
+    for (int k = 0; k < CACHE_KEY_WORDS; k++)
+        key->words[k] = keySeeds[k];
+}
+
+void hashObjectSet(CacheKey *key, Object *objects, int numberOfObjects)
+{
+    int header[2] = {numberOfObjects, HISTOGRAM_COLORS};
+    hashInts(key, header, 2);
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        hashInts(key, &objects[i].ID, 1);
+        hashColorsMatrix(key, objects[i].subColorsMatrix, objects[i].width, objects[i].height, objects[i].pitch);
+    }
+}
+
+void hashPicture(CacheKey *key, Picture *picture)
+{
+    hashColorsMatrix(key, picture->colorsMatrix, picture->width, picture->height, picture->pitch);
+}
+
+static void entryFileName(ResultCache *cache, CacheKey *key, char *file)
+{
+    snprintf(file, MAX_CACHE_PATH, "%s/%016llx%016llx%s", cache->directory, key->words[0], key->words[1], CACHE_FILE_EXTENSION);
+}
+
+/*
+ * The first slot of a key, the key is a hash already so its low bits are used directly
+ */
+static int keySlot(ResultCache *cache, CacheKey *key)
+{
+    return (int)(key->words[0] & (unsigned long long)(cache->numberOfSlots - 1));
+}
+
+static void insertSlot(ResultCache *cache, int index)
+{
+    int slot = keySlot(cache, &cache->entries[index].key);
+    while (cache->slots[slot] >= 0)
+        slot = (slot + 1) & (cache->numberOfSlots - 1);
+    cache->slots[slot] = index;
+}
+
+/*
+ * This function rebuilds the hash table after the entries grew or moved
+ */
+static void rebuildSlots(ResultCache *cache)
+{
+    if (cache->capacity == 0)
+        return;
+    cache->numberOfSlots = 2 * cache->capacity;
+    cache->slots = (int *)realloc(cache->slots, cache->numberOfSlots * sizeof(int));
+    checkMalloc(cache->slots, "cache slots array");
+    memset(cache->slots, -1, cache->numberOfSlots * sizeof(int));
+    for (int i = 0; i < cache->numberOfEntries; i++)
+        insertSlot(cache, i);
+}
+
+static CacheEntry *findEntry(ResultCache *cache, CacheKey *key)
+{
+    if (cache->numberOfSlots == 0)
+        return NULL;
+    for (int slot = keySlot(cache, key); cache->slots[slot] >= 0; slot = (slot + 1) & (cache->numberOfSlots - 1))
+        if (memcmp(&cache->entries[cache->slots[slot]].key, key, sizeof(CacheKey)) == 0)
+            return &cache->entries[cache->slots[slot]];
+    return NULL;
+}
+
+static CacheEntry *addEntry(ResultCache *cache, CacheKey *key, long long size, long long lastUse)
+{
+    int grows = cache->numberOfEntries == cache->capacity;
+    if (grows)
+    {
+        cache->capacity = cache->capacity > 0 ? 2 * cache->capacity : 64;
+        cache->entries = (CacheEntry *)realloc(cache->entries, cache->capacity * sizeof(CacheEntry));
+        checkMalloc(cache->entries, "cache entries array");
+    }
+    CacheEntry *entry = &cache->entries[cache->numberOfEntries++];
+    entry->key = *key;
+    entry->size = size;
+    entry->lastUse = lastUse;
+    cache->totalBytes += size;
+    if (grows)
+        rebuildSlots(cache);
+    else
+        insertSlot(cache, cache->numberOfEntries - 1);
+    return entry;
+}
+
+static int compareEntryUses(const void *a, const void *b)
+{
+    long long difference = ((const CacheEntry *)a)->lastUse - ((const CacheEntry *)b)->lastUse;
+    return difference < 0 ? -1 : difference > 0;
+}
+
+static void evictEntries(ResultCache *cache)
+{
+    char file[MAX_CACHE_PATH];
+    if (cache->totalBytes <= cache->maxBytes)
+        return;
+
+    // the entries are sorted by their last use once, and the least recently used ones are dropped from the front
+    qsort(cache->entries, cache->numberOfEntries, sizeof(CacheEntry), compareEntryUses);
+    int evicted = 0;
+    while (cache->totalBytes > cache->maxBytes && evicted < cache->numberOfEntries)
+    {
+        entryFileName(cache, &cache->entries[evicted].key, file);
+        remove(file);
+        cache->totalBytes -= cache->entries[evicted].size;
+        evicted++;
+    }
+    cache->numberOfEntries -= evicted;
+    memmove(cache->entries, cache->entries + evicted, cache->numberOfEntries * sizeof(CacheEntry));
+    rebuildSlots(cache);
+}
+
+/*
+ * This function removes an entry and its file, the last entry takes its place
+ */
+static void removeEntry(ResultCache *cache, CacheEntry *entry)
+{
+    char file[MAX_CACHE_PATH];
+    entryFileName(cache, &entry->key, file);
+    remove(file);
+    cache->totalBytes -= entry->size;
+    *entry = cache->entries[--cache->numberOfEntries];
+    rebuildSlots(cache);
+}
+
+void openResultCache(ResultCache *cache, const char *directory, long long maxBytes, Object *objects, int numberOfObjects, double matchingThreshold)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->directory = directory;
+    cache->maxBytes = maxBytes;
+    cache->numberOfObjects = numberOfObjects;
+
+    // the object set and the threshold are part of every key
+    initializeKey(&cache->searchKey);
+    hashObjectSet(&cache->searchKey, objects, numberOfObjects);
+    int threshold[2];
+    memcpy(threshold, &matchingThreshold, sizeof(threshold));
+    hashInts(&cache->searchKey, threshold, 2);
+
+    mkdir(directory, 0755);
+    DIR *dir = opendir(directory);
+    checkMalloc(dir, directory);
+    char file[MAX_CACHE_PATH];
+    for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+        CacheKey key;
+        struct stat fileStatus;
+        char extension[16];
+        if (strlen(entry->d_name) != 32 + strlen(CACHE_FILE_EXTENSION) ||
+            sscanf(entry->d_name, "%16llx%16llx%15s", &key.words[0], &key.words[1], extension) != 3 || strcmp(extension, CACHE_FILE_EXTENSION) != 0)
+            continue;
+        snprintf(file, sizeof(file), "%s/%s", directory, entry->d_name);
+        if (stat(file, &fileStatus) == 0)
+            addEntry(cache, &key, fileStatus.st_size, fileStatus.st_mtime);
+    }
+    closedir(dir);
+
+    // the modification times order the entries of earlier runs, this run counts uses on top of them
+    qsort(cache->entries, cache->numberOfEntries, sizeof(CacheEntry), compareEntryUses);
+    for (int i = 0; i < cache->numberOfEntries; i++)
+        cache->entries[i].lastUse = ++cache->clock;
+    rebuildSlots(cache);
+    evictEntries(cache);
+}
+
+static CacheKey pictureKey(ResultCache *cache, Picture *picture)
+{
+    CacheKey key = cache->searchKey;
+    hashPicture(&key, picture);
+    return key;
+}
+
+int lookupResultCache(ResultCache *cache, Picture *picture, Logs *log, Arena *arena)
+{
+    char file[MAX_CACHE_PATH];
+    CacheKey key = pictureKey(cache, picture);
+    CacheEntry *entry = findEntry(cache, &key);
+    if (entry == NULL)
+        return 0;
+
+    entryFileName(cache, &key, file);
+    FILE *fp = fopen(file, "rb");
+    CacheFileHeader header;
+    struct stat fileStatus;
+    // the directory outlives the run, so the header is checked against the objects and the file size before it sizes anything
+    if (fp == NULL || fstat(fileno(fp), &fileStatus) != 0 || fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != CACHE_FILE_VERSION ||
+        header.width != picture->width || header.height != picture->height ||
+        header.numObjectsFound < 0 || header.numObjectsFound > cache->numberOfObjects ||
+        fileStatus.st_size != (off_t)(sizeof(header) + (long long)header.numObjectsFound * sizeof(ResultObjectRecord)))
+    {
+        if (fp != NULL)
+            fclose(fp);
+        removeEntry(cache, entry);
+        return 0;
+    }
+
+    int found = header.numObjectsFound;
+    ResultObjectRecord *records = (ResultObjectRecord *)malloc((found + 1) * sizeof(ResultObjectRecord));
+    checkMalloc(records, "cache records");
+    int complete = (int)fread(records, sizeof(ResultObjectRecord), found, fp) == found;
+    fclose(fp);
+    if (!complete)
+    {
+        free(records);
+        removeEntry(cache, entry);
+        return 0;
+    }
+
+    log->pictureID = picture->ID;
+    log->numObjectsFound = found;
+    log->searchTime = header.searchTime;
+    allocateLogArrays(log, found, arena);
+    for (int i = 0; i < found; i++)
+    {
+        log->objectIDs[i] = records[i].objectID;
+        log->objectPositions[i].row = records[i].row;
+        log->objectPositions[i].column = records[i].column;
+        log->objectScores[i] = records[i].score;
+        log->objectTimes[i] = records[i].computeTime;
+        log->objectOrientations[i] = records[i].orientation;
+    }
+    free(records);
+
+    // the modification time keeps the order of use for the next run
+    entry->lastUse = ++cache->clock;
+    utime(file, NULL);
+    return 1;
+}
+
+void storeResultCache(ResultCache *cache, Picture *picture, Logs *log)
+{
+    char file[MAX_CACHE_PATH], temporaryFile[MAX_CACHE_PATH + 8];
+    CacheKey key = pictureKey(cache, picture);
+    if (findEntry(cache, &key) != NULL)
+        return;
+
+    CacheFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_FILE_MAGIC, sizeof(header.magic));
+    header.version = CACHE_FILE_VERSION;
+    header.width = picture->width;
+    header.height = picture->height;
+    header.numObjectsFound = log->numObjectsFound;
+    header.searchTime = log->searchTime;
+
+    // the entry is written to a temporary file and renamed, so a crash never leaves a partial entry
+    entryFileName(cache, &key, file);
+    snprintf(temporaryFile, sizeof(temporaryFile), "%s.tmp", file);
+    FILE *fp = fopen(temporaryFile, "wb");
+    if (fp == NULL)
+        return;
+    fwrite(&header, sizeof(header), 1, fp);
+    for (int i = 0; i < log->numObjectsFound; i++)
+    {
+        ResultObjectRecord record = {log->objectIDs[i], log->objectPositions[i].row, log->objectPositions[i].column, log->objectOrientations[i],
+                                     log->objectScores[i], log->objectTimes[i]};
+        fwrite(&record, sizeof(record), 1, fp);
+    }
+    fclose(fp);
+    if (rename(temporaryFile, file) != 0)
+    {
+        remove(temporaryFile);
+        return;
+    }
+
+    addEntry(cache, &key, sizeof(header) + (long long)log->numObjectsFound * sizeof(ResultObjectRecord), ++cache->clock);
+    evictEntries(cache);
+}
+
+void closeResultCache(ResultCache *cache)
+{
+    free(cache->entries);
+    free(cache->slots);
+}
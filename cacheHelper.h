@@ -0,0 +1,118 @@
+#pragma once
+#include "helper.h"
+
+#define CACHE_FILE_MAGIC "SIRC"
+#define CACHE_FILE_VERSION 1
+#define CACHE_FILE_EXTENSION ".cache"
+#define CACHE_KEY_WORDS 2
+#define MAX_CACHE_PATH 4096
+
+/*
+ * Result cache entry file layout (native byte order): one CacheFileHeader followed by numObjectsFound ResultObjectRecords.
+ * The file name is the hexadecimal key, a hash of the picture size and colors, the object set and the threshold.
+ */
+struct CacheFileHeaderStruct
+{
+    char magic[4];
+    int version;
+    int width;
+    int height;
+    int numObjectsFound;
+    int reserved;
+    double searchTime;
+};
+typedef struct CacheFileHeaderStruct CacheFileHeader;
+
+struct CacheKeyStruct
+{
+    unsigned long long words[CACHE_KEY_WORDS];
+};
+typedef struct CacheKeyStruct CacheKey;
+
+struct CacheEntryStruct
+{
+    CacheKey key;
+    long long size;
+    long long lastUse;
+};
+typedef struct CacheEntryStruct CacheEntry;
+
+struct ResultCacheStruct
+{
+    const char *directory;
+    long long maxBytes;
+    long long totalBytes;
+    long long clock; // the last use of the most recently used entry
+    int numberOfEntries;
+    int capacity;
+    CacheEntry *entries;
+    int numberOfSlots; // a power of two, twice the capacity
+    int *slots; // open addressing hash table of the entry indices by key, -1 for an empty slot
+    CacheKey searchKey; // the hash of the objects and the threshold every picture key starts from
+    int numberOfObjects; // the most objects an entry can hold
+};
+typedef struct ResultCacheStruct ResultCache;
+
+/*
+ * This function sets a key to the seeds of its independent hashes
+ * @param key: the key
+ * @return: void
+ */
+void initializeKey(CacheKey *key);
+
+/*
+ * This function mixes the IDs, sizes and colors of a set of objects into a key
+ * @param key: the key
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void hashObjectSet(CacheKey *key, Object *objects, int numberOfObjects);
+
+/*
+ * This function mixes the size and colors of a picture, without its row padding, into a key
+ * @param key: the key
+ * @param picture: the picture
+ * @return: void
+ */
+void hashPicture(CacheKey *key, Picture *picture);
+
+/*
+ * This function opens a result cache directory, creating it if needed, and indexes its entries
+ * in the order of their modification times, which record their last use
+ * @param cache: the cache
+ * @param directory: the cache directory
+ * @param maxBytes: the size bound of the entries, the least recently used entries are evicted above it
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void openResultCache(ResultCache *cache, const char *directory, long long maxBytes, Object *objects, int numberOfObjects, double matchingThreshold);
+
+/*
+ * This function looks a picture up in the cache. An entry whose file is missing, corrupted or holds more objects
+ * than the object set is removed and counts as a miss.
+ * @param cache: the cache
+ * @param picture: the picture
+ * @param log: the log, filled on a hit with the picture ID of the picture
+ * @param arena: the arena of the object arrays of the log, NULL to allocate them with malloc
+ * @return: 1 on a hit, 0 on a miss
+ */
+int lookupResultCache(ResultCache *cache, Picture *picture, Logs *log, Arena *arena);
+
+/*
+ * This function stores the log of a picture in the cache and evicts the least recently used entries above the size bound
+ * @param cache: the cache
+ * @param picture: the picture
+ * @param log: the log of the picture
+ * @return: void
+ */
+void storeResultCache(ResultCache *cache, Picture *picture, Logs *log);
+
+/*
+ * This function frees the index of a cache, the entries stay on disk
+ * @param cache: the cache
+ * @return: void
+ */
+void closeResultCache(ResultCache *cache);
@@ -0,0 +1,554 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "cpuHelper.h"
+#include "fftHelper.h"
+
+MatchingBackend matchingBackends[] = {
+    {"gpu", calculateMatchingOnGPU},
+    {"scalar", calculateMatchingOnCPU},
+    {"pruned", calculateMatchingPruned},
+    {"simd", calculateMatchingSIMD},
+    {"float", calculateMatchingFloat},
+    {"fixed", calculateMatchingFixed},
+    {"fft", calculateMatchingFFT},
+    {"histogram", calculateMatchingHistogram},
+    {"ordered", calculateMatchingOrdered},
+    {"auto", calculateMatchingAuto},
+};
+int numberOfMatchingBackends = sizeof(matchingBackends) / sizeof(matchingBackends[0]);
+
+MatchingBackend *findMatchingBackend(const char *name)
+{
+    for (int i = 0; i < numberOfMatchingBackends; i++)
+        if (strcmp(matchingBackends[i].name, name) == 0)
+            return &matchingBackends[i];
+    return NULL;
+}
+
+void calculateMatchingOnCPU(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    // every backend decides a position with calculateMatchingScore, the score written to the log
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+            if (calculateMatchingScore(picture, object, pictureRow, pictureCol) < matchingThreshold)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+}
+
+/*
+ * Whether an object placed at a position matches, summing row by row until the partial value reaches the threshold
+ */
+static inline int matchesPruned(Picture *picture, Object *object, int pictureRow, int pictureCol, double area, double matchingThreshold)
+{
+    double res = 0;
+    for (int i = 0; i < object->height; i++)
+    {
+        int *objectRow = object->subColorsMatrix + i * object->pitch;
+        int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch + pictureCol;
+        for (int j = 0; j < object->width; j++)
+            if (pictureRowColors[j] != 0)
+                res += (double)abs(pictureRowColors[j] - objectRow[j]) / pictureRowColors[j];
+        // the partial sums only grow, so a position whose partial value reached the threshold cannot match
+        if (res / area >= matchingThreshold)
+            return 0;
+    }
+    return 1;
+}
+
+void calculateMatchingPruned(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    double area = object->width * object->height;
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+            if (matchesPruned(picture, object, pictureRow, pictureCol, area, matchingThreshold))
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+}
+
+void calculateMatchingThresholds(Picture *picture, Object *object, int *upperLeftCorners, const double *matchingThresholds, int numberOfThresholds)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    double area = object->width * object->height;
+
+    // only the thresholds without a match so far matter, so a position is pruned at the largest of them
+    int numberOfOpen = numberOfThresholds;
+    double limit = -INFINITY;
+    for (int k = 0; k < numberOfThresholds; k++)
+    {
+        upperLeftCorners[k] = NOT_FOUND;
+        limit = fmax(limit, matchingThresholds[k]);
+    }
+
+    for (int pictureRow = 0; pictureRow <= lastRow && numberOfOpen > 0; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn && numberOfOpen > 0; pictureCol++)
+        {
+            double res = 0;
+            int i;
+            for (i = 0; i < object->height; i++)
+            {
+                int *objectRow = object->subColorsMatrix + i * object->pitch;
+                int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch + pictureCol;
+                for (int j = 0; j < object->width; j++)
+                    if (pictureRowColors[j] != 0)
+                        res += (double)abs(pictureRowColors[j] - objectRow[j]) / pictureRowColors[j];
+                if (res / area >= limit)
+                    break;
+            }
+            if (i < object->height)
+                continue;
+
+            // the value is complete and summed in the order of calculateMatchingOnCPU, classify it against every open threshold
+            limit = -INFINITY;
+            for (int k = 0; k < numberOfThresholds; k++)
+                if (upperLeftCorners[k] == NOT_FOUND)
+                {
+                    if (res / area < matchingThresholds[k])
+                    {
+                        upperLeftCorners[k] = pictureRow * picture->width + pictureCol;
+                        numberOfOpen--;
+                    }
+                    else
+                        limit = fmax(limit, matchingThresholds[k]);
+                }
+        }
+}
+
+/*
+ * The SIMD kernel with the object dimensions as arguments. It is inlined into the kernels of fixed object sizes,
+ * where the dimensions are constants, so the loop over a row has a known trip count and is unrolled by up to 16 members.
+ * Rows are not unrolled completely, a row of 200 members would not fit the instruction cache.
+ */
+static inline __attribute__((always_inline)) void matchingSIMDKernel(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold,
+                                                                     const int objectWidth, const int objectHeight)
+{
+    int lastRow = picture->height - objectHeight;
+    int lastColumn = picture->width - objectWidth;
+    double area = objectWidth * objectHeight;
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+    {
+        int pictureCol = 0;
+        for (; pictureCol + SIMD_LANES - 1 <= lastColumn; pictureCol += SIMD_LANES)
+        {
+            double res[SIMD_LANES] = {0};
+            for (int i = 0; i < objectHeight; i++)
+            {
+                int *objectRow = object->subColorsMatrix + i * object->pitch;
+                int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch + pictureCol;
+                #pragma GCC unroll 16
+                for (int j = 0; j < objectWidth; j++)
+                {
+                    int objectColor = objectRow[j];
+                    // lanes with a zero color add 0 / 1, which keeps their sum exact without a branch
+                    #pragma omp simd
+                    for (int lane = 0; lane < SIMD_LANES; lane++)
+                    {
+                        int pictureColor = pictureRowColors[j + lane];
+                        int isColored = pictureColor != 0;
+                        res[lane] += (double)(abs(pictureColor - objectColor) * isColored) / (double)(pictureColor + 1 - isColored);
+                    }
+                }
+            }
+            for (int lane = 0; lane < SIMD_LANES; lane++)
+                if (res[lane] / area < matchingThreshold)
+                {
+                    *upperLeftCorner = pictureRow * picture->width + pictureCol + lane;
+                    return;
+                }
+        }
+        // the positions left over at the end of the row
+        for (; pictureCol <= lastColumn; pictureCol++)
+            if (calculateMatchingScore(picture, object, pictureRow, pictureCol) < matchingThreshold)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+    }
+}
+
+void calculateMatchingSIMD(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    matchingSIMDKernel(picture, object, upperLeftCorner, matchingThreshold, object->width, object->height);
+}
+
+// one kernel per fixed object size, calculateMatchingFixed10 searches objects of 10 x 10
+#define FIXED_SIZE(D)                                                                                                    \
+    static void calculateMatchingFixed##D(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold) \
+    {                                                                                                                    \
+        matchingSIMDKernel(picture, object, upperLeftCorner, matchingThreshold, D, D);                                   \
+    }
+FIXED_OBJECT_SIZES
+#undef FIXED_SIZE
+
+struct FixedKernelStruct
+{
+    int size;
+    MatchingFunction function;
+};
+typedef struct FixedKernelStruct FixedKernel;
+
+#define FIXED_SIZE(D) {D, calculateMatchingFixed##D},
+static FixedKernel fixedKernels[] = {FIXED_OBJECT_SIZES {0, NULL}};
+#undef FIXED_SIZE
+
+MatchingFunction findFixedKernel(Object *object)
+{
+    if (object->width != object->height)
+        return NULL;
+    for (int k = 0; fixedKernels[k].function != NULL; k++)
+        if (fixedKernels[k].size == object->width)
+            return fixedKernels[k].function;
+    return NULL;
+}
+
+void calculateMatchingFixed(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    MatchingFunction fixedKernel = findFixedKernel(object);
+    if (fixedKernel != NULL)
+        fixedKernel(picture, object, upperLeftCorner, matchingThreshold);
+    else
+        calculateMatchingSIMD(picture, object, upperLeftCorner, matchingThreshold);
+}
+
+/*
+ * Whether all colors of a matrix are in 0 to FLOAT_EXACT_COLORS - 1
+ */
+static int hasFloatExactColors(const int *colorsMatrix, int width, int height, int pitch)
+{
+    int isExact = 1;
+    for (int i = 0; i < height; i++)
+        for (int j = 0; j < width; j++)
+            isExact &= colorsMatrix[i * pitch + j] >= 0 && colorsMatrix[i * pitch + j] < FLOAT_EXACT_COLORS;
+    return isExact;
+}
+
+void calculateMatchingFloat(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    int objectWidth = object->width;
+    int objectHeight = object->height;
+    int lastRow = picture->height - objectHeight;
+    int lastColumn = picture->width - objectWidth;
+    double area = objectWidth * objectHeight;
+    // the float terms and their sum are rounded, the limit is wider than both, so a matching position is never left out
+    double limit = matchingThreshold * area * (1 + 2 * (area + 2) * FLT_EPSILON);
+
+    if (!hasFloatExactColors(picture->colorsMatrix, picture->width, picture->height, picture->pitch) ||
+        !hasFloatExactColors(object->subColorsMatrix, objectWidth, objectHeight, object->pitch) || (area + 2) * FLT_EPSILON >= 0.5)
+    {
+        calculateMatchingSIMD(picture, object, upperLeftCorner, matchingThreshold);
+        return;
+    }
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+    {
+        int pictureCol = 0;
+        for (; pictureCol + FLOAT_SIMD_LANES - 1 <= lastColumn; pictureCol += FLOAT_SIMD_LANES)
+        {
+            float res[FLOAT_SIMD_LANES] = {0};
+            for (int i = 0; i < objectHeight; i++)
+            {
+                int *objectRow = object->subColorsMatrix + i * object->pitch;
+                int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch + pictureCol;
+                for (int j = 0; j < objectWidth; j++)
+                {
+                    int objectColor = objectRow[j];
+                    // lanes with a zero color add 0 / 1, which keeps their sum exact without a branch
+                    #pragma omp simd
+                    for (int lane = 0; lane < FLOAT_SIMD_LANES; lane++)
+                    {
+                        int pictureColor = pictureRowColors[j + lane];
+                        int isColored = pictureColor != 0;
+                        res[lane] += (float)(abs(pictureColor - objectColor) * isColored) / (float)(pictureColor + 1 - isColored);
+                    }
+                }
+            }
+            // the lanes are checked in order, so the first of several candidates is evaluated first
+            for (int lane = 0; lane < FLOAT_SIMD_LANES; lane++)
+                if (res[lane] < limit && calculateMatchingScore(picture, object, pictureRow, pictureCol + lane) < matchingThreshold)
+                {
+                    *upperLeftCorner = pictureRow * picture->width + pictureCol + lane;
+                    return;
+                }
+        }
+        // the positions left over at the end of the row
+        for (; pictureCol <= lastColumn; pictureCol++)
+            if (calculateMatchingScore(picture, object, pictureRow, pictureCol) < matchingThreshold)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+    }
+}
+
+void calculateMatchingFFT(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    int positionRows = picture->height - object->height + 1;
+    int positionColumns = picture->width - object->width + 1;
+
+    double *lowerBounds = (double *)malloc((size_t)positionRows * positionColumns * sizeof(double));
+    checkMalloc(lowerBounds, "matching lower bounds");
+    if (!matchingLowerBounds(picture, object, lowerBounds))
+    {
+        free(lowerBounds);
+        calculateMatchingOnCPU(picture, object, upperLeftCorner, matchingThreshold);
+        return;
+    }
+
+    // only the positions the bound cannot rule out are evaluated, in row-major order
+    for (int pictureRow = 0; pictureRow < positionRows; pictureRow++)
+        for (int pictureCol = 0; pictureCol < positionColumns; pictureCol++)
+            if (lowerBounds[pictureRow * positionColumns + pictureCol] < matchingThreshold &&
+                calculateMatchingScore(picture, object, pictureRow, pictureCol) < matchingThreshold)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                free(lowerBounds);
+                return;
+            }
+    free(lowerBounds);
+}
+
+void calculateMatchingAuto(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    if (fftPaysOff(picture, object))
+        calculateMatchingFFT(picture, object, upperLeftCorner, matchingThreshold);
+    else
+        calculateMatchingPruned(picture, object, upperLeftCorner, matchingThreshold);
+}
+
+/*
+ * A lower bound of the matching value sum of a window from its color histogram and the cumulative object histogram.
+ * The zero colors of the window (colorCounts[0]) pair with object members at no cost, every other window member P
+ * pairs with one object member O and costs abs(P - O) / P = the sum over the cuts c between them of 1 / P.
+ * At least F_P(c) - F_O(c) pairs cross cut c upwards with P <= c, costing at least 1 / c each, and at least
+ * F_O(c) - F_P(c) - zeros pairs cross it downwards with P above c, costing at least 1 / (largest window color).
+ */
+static double histogramLowerBound(const int *windowCounts, const int *objectCounts, const double *inverseColors)
+{
+    int largestColor = HISTOGRAM_COLORS - 1;
+    while (largestColor > 0 && windowCounts[largestColor] == 0)
+        largestColor--;
+    if (largestColor == 0)
+        return 0;
+
+    int zeros = windowCounts[0], windowCumulative = 0;
+    double upwards = 0, downwards = 0;
+    for (int c = 0; c < HISTOGRAM_COLORS - 1; c++)
+    {
+        windowCumulative += c > 0 ? windowCounts[c] : 0;
+        int difference = windowCumulative - objectCounts[c];
+        if (difference > 0)
+            upwards += difference * inverseColors[c];
+        else if (-difference > zeros)
+            downwards += -difference - zeros;
+    }
+    return upwards + downwards * inverseColors[largestColor];
+}
+
+void calculateMatchingHistogram(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    double area = object->width * object->height;
+    // the bound is rounded in its sums, and the direct sums of the value are rounded as well
+    double roundingFactor = 1 - (area + HISTOGRAM_COLORS + 4) * DBL_EPSILON;
+
+    Object countedObject = *object;
+    if (countedObject.colorCounts == NULL)
+        computeColorCounts(&countedObject);
+    int outOfRange = countedObject.colorCounts == NULL;
+    for (int i = 0; i < picture->height && !outOfRange; i++)
+        for (int j = 0; j < picture->width; j++)
+            outOfRange |= picture->colorsMatrix[i * picture->pitch + j] < 0 || picture->colorsMatrix[i * picture->pitch + j] >= HISTOGRAM_COLORS;
+    if (outOfRange)
+    {
+        if (countedObject.colorCounts != object->colorCounts)
+            free(countedObject.colorCounts);
+        calculateMatchingPruned(picture, object, upperLeftCorner, matchingThreshold);
+        return;
+    }
+
+    double inverseColors[HISTOGRAM_COLORS];
+    inverseColors[0] = 0;
+    for (int c = 1; c < HISTOGRAM_COLORS; c++)
+        inverseColors[c] = 1.0 / c;
+
+    int found = 0;
+    for (int pictureRow = 0; pictureRow <= lastRow && !found; pictureRow++)
+    {
+        // the window histogram slides along the row, one column out and one column in
+        int windowCounts[HISTOGRAM_COLORS] = {0};
+        for (int i = 0; i < object->height; i++)
+            for (int j = 0; j < object->width; j++)
+                windowCounts[picture->colorsMatrix[(pictureRow + i) * picture->pitch + j]]++;
+
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+        {
+            if (pictureCol > 0)
+                for (int i = 0; i < object->height; i++)
+                {
+                    int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch;
+                    windowCounts[pictureRowColors[pictureCol - 1]]--;
+                    windowCounts[pictureRowColors[pictureCol + object->width - 1]]++;
+                }
+            if (histogramLowerBound(windowCounts, countedObject.colorCounts, inverseColors) * roundingFactor / area >= matchingThreshold)
+                continue;
+            if (matchesPruned(picture, object, pictureRow, pictureCol, area, matchingThreshold))
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                found = 1;
+                break;
+            }
+        }
+    }
+    if (countedObject.colorCounts != object->colorCounts)
+        free(countedObject.colorCounts);
+}
+
+static int compareVisitBlocks(const void *a, const void *b)
+{
+    const VisitBlock *first = (const VisitBlock *)a, *second = (const VisitBlock *)b;
+    if (first->weight != second->weight)
+        return first->weight < second->weight ? 1 : -1;
+    return first->objectOffset - second->objectOffset;
+}
+
+static int numberOfVisitBlocks(Object *object)
+{
+    return (object->width + VISIT_BLOCK_LENGTH - 1) / VISIT_BLOCK_LENGTH * object->height;
+}
+
+void computeVisitBlocks(Object *object)
+{
+    object->visitBlocks = NULL;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+            if (object->subColorsMatrix[i * object->pitch + j] < 0 || object->subColorsMatrix[i * object->pitch + j] >= HISTOGRAM_COLORS)
+                return;
+
+    // the blocks are runs of a row, so every block reads consecutive colors of the object and the picture
+    int blocksPerRow = (object->width + VISIT_BLOCK_LENGTH - 1) / VISIT_BLOCK_LENGTH;
+    VisitBlock *blocks = (VisitBlock *)malloc((numberOfVisitBlocks(object) + 1) * sizeof(VisitBlock));
+    checkMalloc(blocks, "visit blocks array");
+    for (int i = 0; i < object->height; i++)
+        for (int b = 0; b < blocksPerRow; b++)
+        {
+            VisitBlock *block = &blocks[i * blocksPerRow + b];
+            block->row = i;
+            block->column = b * VISIT_BLOCK_LENGTH;
+            block->objectOffset = i * object->pitch + block->column;
+            block->length = object->width - block->column < VISIT_BLOCK_LENGTH ? object->width - block->column : VISIT_BLOCK_LENGTH;
+            block->weight = 0;
+        }
+    object->visitBlocks = blocks;
+}
+
+int orderVisitBlocks(Picture *picture, Object *objects, int numberOfObjects)
+{
+    // the expected value abs(P - O) / P of every object color O against a member P drawn from the picture
+    long long pictureCounts[HISTOGRAM_COLORS] = {0};
+    for (int i = 0; i < picture->height; i++)
+        for (int j = 0; j < picture->width; j++)
+        {
+            int pictureColor = picture->colorsMatrix[i * picture->pitch + j];
+            if (pictureColor < 0 || pictureColor >= HISTOGRAM_COLORS)
+                return 0;
+            pictureCounts[pictureColor]++;
+        }
+    double expectedValues[HISTOGRAM_COLORS];
+    double members = (double)picture->width * picture->height;
+    for (int objectColor = 0; objectColor < HISTOGRAM_COLORS; objectColor++)
+    {
+        expectedValues[objectColor] = 0;
+        for (int pictureColor = 1; pictureColor < HISTOGRAM_COLORS; pictureColor++)
+            expectedValues[objectColor] += pictureCounts[pictureColor] * ((double)abs(pictureColor - objectColor) / pictureColor);
+        expectedValues[objectColor] /= members;
+    }
+
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        VisitBlock *blocks = objects[i].visitBlocks;
+        if (blocks == NULL)
+            continue;
+        int numberOfBlocks = numberOfVisitBlocks(&objects[i]);
+        for (int b = 0; b < numberOfBlocks; b++)
+        {
+            blocks[b].weight = 0;
+            for (int j = 0; j < blocks[b].length; j++)
+                blocks[b].weight += expectedValues[objects[i].subColorsMatrix[blocks[b].objectOffset + j]];
+            blocks[b].weight /= blocks[b].length;
+        }
+        qsort(blocks, numberOfBlocks, sizeof(VisitBlock), compareVisitBlocks);
+    }
+    return 1;
+}
+
+/*
+ * The search of calculateMatchingOrdered with the blocks of the object in a given order
+ */
+static void searchVisitBlocks(Picture *picture, Object *object, const VisitBlock *blocks, int *upperLeftCorner, double matchingThreshold)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    int numberOfBlocks = numberOfVisitBlocks(object);
+    double area = object->width * object->height;
+    // both orders of summing are within area * DBL_EPSILON / 2 of the exact value relative to its size
+    double limit = matchingThreshold * area * (1 + 2 * (area + 4) * DBL_EPSILON);
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+        {
+            const int *window = picture->colorsMatrix + (size_t)pictureRow * picture->pitch + pictureCol;
+            double res = 0;
+            int b;
+            for (b = 0; b < numberOfBlocks; b++)
+            {
+                const int *objectColors = object->subColorsMatrix + blocks[b].objectOffset;
+                const int *pictureColors = window + blocks[b].row * picture->pitch + blocks[b].column;
+                for (int j = 0; j < blocks[b].length; j++)
+                    if (pictureColors[j] != 0)
+                        res += (double)abs(pictureColors[j] - objectColors[j]) / pictureColors[j];
+                // the terms are non-negative, so a position whose partial value reached the limit cannot match
+                if (res >= limit)
+                    break;
+            }
+            if (b == numberOfBlocks && calculateMatchingScore(picture, object, pictureRow, pictureCol) < matchingThreshold)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+        }
+}
+
+void calculateMatchingOrdered(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold)
+{
+    if (picture->height < object->height || picture->width < object->width)
+        return;
+    if (object->visitBlocks != NULL)
+    {
+        searchVisitBlocks(picture, object, object->visitBlocks, upperLeftCorner, matchingThreshold);
+        return;
+    }
+
+    // the workers order the blocks of their objects once per picture, other objects get blocks for this picture only
+    Object orderedObject = *object;
+    computeVisitBlocks(&orderedObject);
+    if (orderedObject.visitBlocks != NULL && orderVisitBlocks(picture, &orderedObject, 1))
+        searchVisitBlocks(picture, object, orderedObject.visitBlocks, upperLeftCorner, matchingThreshold);
+    else
+        calculateMatchingPruned(picture, object, upperLeftCorner, matchingThreshold);
+    free(orderedObject.visitBlocks);
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include "helper.h"
+
+#define SIMD_LANES 8
+#define FLOAT_SIMD_LANES 16 // float lanes fit twice as many positions in a vector
+#define FLOAT_EXACT_COLORS (1 << 23) // colors below this and their differences are exact floats
+#define VISIT_BLOCK_LENGTH 8 // object members of a row visited between two budget checks
+
+// the square object sizes with kernels of their own, make FIXED_SIZES="10 16 32" builds others
+#ifndef FIXED_OBJECT_SIZES
+#define FIXED_OBJECT_SIZES FIXED_SIZE(10) FIXED_SIZE(15) FIXED_SIZE(20) FIXED_SIZE(40) FIXED_SIZE(200)
+#endif
+
+/*
+ * A run of up to VISIT_BLOCK_LENGTH members of an object row, the unit of the visiting order of the ordered backend
+ */
+struct VisitBlockStruct
+{
+    int objectOffset; // of the first member in the object colors
+    int row;
+    int column;
+    int length;
+    double weight; // the expected value per member against the colors of the last picture the blocks were ordered for
+};
+typedef struct VisitBlockStruct VisitBlock;
+
+struct MatchingBackendStruct
+{
+    const char *name;
+    MatchingFunction function;
+};
+typedef struct MatchingBackendStruct MatchingBackend;
+
+extern MatchingBackend matchingBackends[];
+extern int numberOfMatchingBackends;
+
+/*
+ * This function finds a matching backend by name
+ * @param name: the backend name
+ * @return: the backend, or NULL if there is no backend with this name
+ */
+MatchingBackend *findMatchingBackend(const char *name);
+
+/*
+ * This function searches an object in a picture on the CPU, computing the full matching value of every position
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingOnCPU(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture on the CPU and stops summing a position as soon as
+ * its partial matching value reaches the threshold. The terms are non-negative, so the decisions are
+ * the same as calculateMatchingOnCPU.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingPruned(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture for several thresholds in one pass. Every position is summed once,
+ * pruned like calculateMatchingPruned at the largest threshold without a match so far, and classified against
+ * every threshold without a match, so each threshold gets the same position as a separate search.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorners: the index of the upper left corner of the first match of every threshold, NOT_FOUND if there is none
+ * @param matchingThresholds: the matching thresholds, in any order
+ * @param numberOfThresholds: the number of thresholds
+ * @return: void
+ */
+void calculateMatchingThresholds(Picture *picture, Object *object, int *upperLeftCorners, const double *matchingThresholds, int numberOfThresholds);
+
+/*
+ * This function searches an object in a picture on the CPU with SIMD_LANES neighbouring positions per vector.
+ * Every lane sums its position in the same order as calculateMatchingOnCPU, so the results are identical.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingSIMD(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function finds the kernel of the size of an object among FIXED_OBJECT_SIZES
+ * @param object: pointer to the object
+ * @return: the kernel, or NULL if the object is not square or its size has no kernel
+ */
+MatchingFunction findFixedKernel(Object *object);
+
+/*
+ * This function searches an object in a picture like calculateMatchingSIMD, with the kernel compiled for the size
+ * of the object when it is one of FIXED_OBJECT_SIZES. With constant dimensions the loop over a row has a known
+ * trip count and is unrolled by up to 16 members, the results are identical. Other objects are searched with calculateMatchingSIMD.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingFixed(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture on the CPU like calculateMatchingSIMD, but sums FLOAT_SIMD_LANES
+ * positions per vector in float. With exact colors every float term is within one float rounding of abs((P - O) / P),
+ * and the float sum of the area terms is within (area + 2) * FLT_EPSILON of the exact value relative to its size.
+ * A position whose float sum is below the threshold widened by that bound is evaluated again in double
+ * like calculateMatchingOnCPU, the others cannot match, so the decisions are the same as calculateMatchingOnCPU.
+ * Pictures and objects with negative colors or colors of FLOAT_EXACT_COLORS and more are searched with calculateMatchingSIMD.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingFloat(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture on the CPU, evaluating only the positions whose
+ * FFT lower bound (see matchingLowerBounds) is below the threshold. The bound never exceeds the value,
+ * so the decisions are the same as calculateMatchingOnCPU. Pictures with negative colors are searched directly.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingFFT(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture with calculateMatchingFFT for objects large enough
+ * for the prefilter to pay off (see fftPaysOff) and with calculateMatchingPruned otherwise
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingAuto(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function searches an object in a picture on the CPU and skips the windows whose color histogram
+ * proves they cannot match (see histogramLowerBound), the other windows are evaluated like calculateMatchingPruned.
+ * The histogram of the object is taken from colorCounts when computeColorCounts was called, computed here otherwise.
+ * Pictures or objects with colors outside 0 to HISTOGRAM_COLORS - 1 are searched like calculateMatchingPruned.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingHistogram(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function cuts the rows of an object into the blocks of the ordered backend, once per object
+ * @param object: pointer to the object, its visit blocks are left NULL if it has colors outside 0 to HISTOGRAM_COLORS - 1
+ * @return: void
+ */
+void computeVisitBlocks(Object *object);
+
+/*
+ * This function orders the visit blocks of the objects for a picture: the color histogram of the picture and the
+ * expected value of every object color against it are computed once, then the blocks of every object are sorted
+ * by decreasing expected value per member. Objects without visit blocks are skipped.
+ * @param picture: pointer to the picture
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: 1 if the blocks were ordered, 0 if the picture has colors outside 0 to HISTOGRAM_COLORS - 1, then they keep their order
+ */
+int orderVisitBlocks(Picture *picture, Object *objects, int numberOfObjects);
+
+/*
+ * This function searches an object in a picture on the CPU and visits the members of every position in the order
+ * that rejects non-matching positions soonest. The object rows are cut into blocks of up to VISIT_BLOCK_LENGTH members,
+ * and the blocks are visited by decreasing expected value per member against the colors of the picture, so the
+ * members far from the common picture colors come first. A position is left once its partial value reaches the
+ * threshold widened by the rounding error of summing in another order, and the positions left are evaluated again
+ * like calculateMatchingOnCPU, so the decisions are the same as calculateMatchingOnCPU in any block order.
+ * The visit blocks of the object are used as they were ordered (see orderVisitBlocks), an object without them gets
+ * blocks ordered for this picture on every call. Objects without them with colors outside 0 to HISTOGRAM_COLORS - 1,
+ * or with pictures with such colors, are searched like calculateMatchingPruned.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingOrdered(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include <omp.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -25,14 +26,14 @@ inline void gpuAssert(cudaError_t code, const char *file, int line, bool abort =
     }
 }
 
-__device__ void calculateMatch(int objectDimension, int pictureDimension, int* d_pictureColorsMatrix, int* d_objectSubColorsMatrix, int picrureRow, int pictureCol, double* res)
+__device__ void calculateMatch(int objectWidth, int objectHeight, int objectPitch, int picturePitch, int* d_pictureColorsMatrix, int* d_objectSubColorsMatrix, int picrureRow, int pictureCol, double* res)
 {
-        for( int i = 0; i < objectDimension; i++)
+        for( int i = 0; i < objectHeight; i++)
         {
-            for( int j = 0; j < objectDimension; j++)
+            for( int j = 0; j < objectWidth; j++)
             {
-                int objectColor = d_objectSubColorsMatrix[i * objectDimension + j];
-                int pictureColor = d_pictureColorsMatrix[(picrureRow + i) * pictureDimension + (pictureCol + j)];
+                int objectColor = d_objectSubColorsMatrix[i * objectPitch + j];
+                int pictureColor = d_pictureColorsMatrix[(picrureRow + i) * picturePitch + (pictureCol + j)];
                 if (pictureColor != 0)
                     *(res) += (double)abs((pictureColor - objectColor)) / pictureColor;
             }
@@ -41,27 +42,28 @@ __device__ void calculateMatch(int objectDimension, int pictureDimension, int* d
 
 /*
  * Kernel function for calculating the difference between the colors of the overlapping pixels of the Object and the Picture using the formula:abs((P - O) / P)
- * @param d_pictureColorsMatrix - the colors matrix of the Picture on the GPU
- * @param d_objectSubColorsMatrix - the sub colors matrix of the Object on the GPU
- * @param d_matchingValue - the matching value that will be returned to the host
- * @param d_objectDimension - the dimension of the Object
- * @param d_pictureDimension - the dimension of the Picture
- * @param d_upperLeftCorner - the index of the upper-left corner of the object in the picture
+ * @param d_pictureColorsMatrix - the colors matrix of the Picture on the GPU, rows picturePitch colors apart
+ * @param d_objectSubColorsMatrix - the sub colors matrix of the Object on the GPU, rows objectPitch colors apart
+ * @param d_matchingThreshold - the matching threshold
+ * @param objectWidth, objectHeight, objectPitch - the size of the Object
+ * @param pictureWidth, pictureHeight, picturePitch - the size of the Picture
+ * @param d_upperLeftCorner - the index of the upper-left corner of the first match in row-major order, INT_MAX if there is none
  */
-__global__ void calculateMatching(int *d_pictureColorsMatrix, int *d_objectSubColorsMatrix, double *d_matchingThreshold, int *d_objectDimension, int *d_pictureDimension, int *d_upperLeftCorner)
+__global__ void calculateMatching(int *d_pictureColorsMatrix, int *d_objectSubColorsMatrix, double *d_matchingThreshold, int objectWidth, int objectHeight, int objectPitch,
+                                  int pictureWidth, int pictureHeight, int picturePitch, int *d_upperLeftCorner)
 {
     int globalThreadIndex = blockDim.x * blockIdx.x + threadIdx.x;
+    int columns = pictureWidth - objectWidth + 1;
+    int rows = pictureHeight - objectHeight + 1;
 
-    if (globalThreadIndex < ((*d_pictureDimension) - (*d_objectDimension) + 1) * ((*d_pictureDimension) - (*d_objectDimension) + 1))
+    if (globalThreadIndex < columns * rows)
     {
-        double res;
-        int pictureRow = globalThreadIndex / ((*d_pictureDimension) - (*d_objectDimension) + 1);
-        int pictureCol = globalThreadIndex % ((*d_pictureDimension) - (*d_objectDimension) + 1);
-        if (pictureCol < 0 || pictureCol >= (*d_pictureDimension) - (*d_objectDimension) + 1 || pictureRow < 0 || pictureRow >= (*d_pictureDimension) - (*d_objectDimension) + 1)
-            return;
-        calculateMatch(*d_objectDimension, *d_pictureDimension, d_pictureColorsMatrix, d_objectSubColorsMatrix, pictureRow, pictureCol, &res);
-        if (res / ((*d_objectDimension) * (*d_objectDimension)) < (*d_matchingThreshold))
-            (*d_upperLeftCorner) = pictureRow * (*d_pictureDimension) + pictureCol;
+        double res = 0;
+        int pictureRow = globalThreadIndex / columns;
+        int pictureCol = globalThreadIndex % columns;
+        calculateMatch(objectWidth, objectHeight, objectPitch, picturePitch, d_pictureColorsMatrix, d_objectSubColorsMatrix, pictureRow, pictureCol, &res);
+        if (res / (objectWidth * objectHeight) < (*d_matchingThreshold))
+            atomicMin(d_upperLeftCorner, pictureRow * pictureWidth + pictureCol);
     }
 }
 
@@ -72,49 +74,43 @@ __host__ void calculateMatchingOnGPU(Picture *picture, Object *object, int *uppe
     gpuErrchk(cudaMalloc((void **)&d_matchingThreshold, sizeof(double)));
     gpuErrchk(cudaMemcpy(d_matchingThreshold, &matchingThreshold, sizeof(double), cudaMemcpyHostToDevice));
 
-    // Allocate memory and copy for the upper left corner on the GPU
+    // Allocate memory and copy for the upper left corner on the GPU, the kernel keeps the smallest matching index
+    int firstMatch = INT_MAX;
     int *d_upperLeftCorner;
     gpuErrchk(cudaMalloc((void **)&d_upperLeftCorner, sizeof(int)));
-    gpuErrchk(cudaMemcpy(d_upperLeftCorner, upperLeftCorner, sizeof(int), cudaMemcpyHostToDevice));
+    gpuErrchk(cudaMemcpy(d_upperLeftCorner, &firstMatch, sizeof(int), cudaMemcpyHostToDevice));
 
-    // Allocate memory and copy for the picture colors matrix on the GPU
+    // Allocate memory and copy for the picture colors matrix on the GPU, the row padding is copied as well
+    size_t pictureSize = (size_t)picture->pitch * picture->height * sizeof(int);
     int *d_pictureColorsMatrix;
-    gpuErrchk(cudaMalloc((void **)&d_pictureColorsMatrix, picture->dimension * picture->dimension * sizeof(int)));
-    gpuErrchk(cudaMemcpy(d_pictureColorsMatrix, picture->colorsMatrix, picture->dimension * picture->dimension * sizeof(int), cudaMemcpyHostToDevice));
-
-    // Allocate memory and copy for the picture dimension on the GPU
-    int *d_pictureDimension;
-    gpuErrchk(cudaMalloc((void **)&d_pictureDimension, sizeof(int)));
-    gpuErrchk(cudaMemcpy(d_pictureDimension, &picture->dimension, sizeof(int), cudaMemcpyHostToDevice));
-
-    // Allocate memory and copy for the object dimension on the GPU
-    int *d_objectDimension;
-    gpuErrchk(cudaMalloc((void **)&d_objectDimension, sizeof(int)));
-    gpuErrchk(cudaMemcpy(d_objectDimension, &object->dimension, sizeof(int), cudaMemcpyHostToDevice));
+    gpuErrchk(cudaMalloc((void **)&d_pictureColorsMatrix, pictureSize));
+    gpuErrchk(cudaMemcpy(d_pictureColorsMatrix, picture->colorsMatrix, pictureSize, cudaMemcpyHostToDevice));
 
     // Allocate memory and copy for the object sub colors matrix on the GPU
+    size_t objectSize = (size_t)object->pitch * object->height * sizeof(int);
     int *d_objectSubColorsMatrix;
-    gpuErrchk(cudaMalloc((void **)&d_objectSubColorsMatrix, (object->dimension * object->dimension * sizeof(int))));
-    gpuErrchk(cudaMemcpy(d_objectSubColorsMatrix, object->subColorsMatrix, (object->dimension * object->dimension * sizeof(int)), cudaMemcpyHostToDevice));
+    gpuErrchk(cudaMalloc((void **)&d_objectSubColorsMatrix, objectSize));
+    gpuErrchk(cudaMemcpy(d_objectSubColorsMatrix, object->subColorsMatrix, objectSize, cudaMemcpyHostToDevice));
 
-    int size = (picture->dimension - object->dimension + 1) * (picture->dimension - object->dimension + 1);
+    int size = (picture->width - object->width + 1) * (picture->height - object->height + 1);
     int blocksPerGrid = (size + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK;
 
     // call the kernel function
-    calculateMatching<<<blocksPerGrid, THREADS_PER_BLOCK>>>(d_pictureColorsMatrix, d_objectSubColorsMatrix, d_matchingThreshold, d_objectDimension, d_pictureDimension, d_upperLeftCorner);
+    calculateMatching<<<blocksPerGrid, THREADS_PER_BLOCK>>>(d_pictureColorsMatrix, d_objectSubColorsMatrix, d_matchingThreshold, object->width, object->height, object->pitch,
+                                                            picture->width, picture->height, picture->pitch, d_upperLeftCorner);
 
     // check if the kernel function was called successfully
     gpuErrchk(cudaPeekAtLastError());
     gpuErrchk(cudaDeviceSynchronize());
 
     // copy the upper left corner row from the GPU to the host
-    gpuErrchk(cudaMemcpy(upperLeftCorner, d_upperLeftCorner, sizeof(int), cudaMemcpyDeviceToHost));
+    gpuErrchk(cudaMemcpy(&firstMatch, d_upperLeftCorner, sizeof(int), cudaMemcpyDeviceToHost));
+    if (firstMatch != INT_MAX)
+        *upperLeftCorner = firstMatch;
 
     // free the memory on the GPU
     cudaFree(d_matchingThreshold);
     cudaFree(d_pictureColorsMatrix);
     cudaFree(d_objectSubColorsMatrix);
-    cudaFree(d_pictureDimension);
-    cudaFree(d_objectDimension);
     cudaFree(d_upperLeftCorner);
 }
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include "fftHelper.h"
+
+// the upper limits of the picture color bands, the last band holds every larger color
+static const int bandLimits[FFT_COLOR_BANDS - 1] = {12, 25, 50};
+
+/*
+ * This function computes the twiddle factors exp(-2 pi i k / length) of a transform, recurrences lose accuracy on long transforms
+ * @return: the twiddle factors, interleaved real and imaginary parts of the first length / 2 powers
+ */
+static double *fftTwiddles(int length)
+{
+    double *twiddles = (double *)malloc((length / 2 + 1) * 2 * sizeof(double));
+    checkMalloc(twiddles, "FFT twiddle factors");
+    for (int k = 0; k < length / 2; k++)
+    {
+        twiddles[2 * k] = cos(-2 * M_PI * k / length);
+        twiddles[2 * k + 1] = sin(-2 * M_PI * k / length);
+    }
+    return twiddles;
+}
+
+static void fftWithTwiddles(double *signal, int length, const double *twiddles, int inverse)
+{
+    // bit reversal permutation
+    for (int i = 1, j = 0; i < length; i++)
+    {
+        int bit = length >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            double re = signal[2 * i], im = signal[2 * i + 1];
+            signal[2 * i] = signal[2 * j];
+            signal[2 * i + 1] = signal[2 * j + 1];
+            signal[2 * j] = re;
+            signal[2 * j + 1] = im;
+        }
+    }
+
+    // the inverse transform uses the conjugate twiddle factors
+    double sign = inverse ? -1 : 1;
+    for (int half = 1; half < length; half <<= 1)
+    {
+        int step = length / (2 * half);
+        for (int k = 0; k < half; k++)
+        {
+            double wRe = twiddles[2 * k * step], wIm = sign * twiddles[2 * k * step + 1];
+            for (int i = k; i < length; i += 2 * half)
+            {
+                double *a = signal + 2 * i, *b = signal + 2 * (i + half);
+                double tRe = b[0] * wRe - b[1] * wIm;
+                double tIm = b[0] * wIm + b[1] * wRe;
+                b[0] = a[0] - tRe;
+                b[1] = a[1] - tIm;
+                a[0] += tRe;
+                a[1] += tIm;
+            }
+        }
+    }
+}
+
+void fft(double *signal, int length, int inverse)
+{
+    double *twiddles = fftTwiddles(length);
+    fftWithTwiddles(signal, length, twiddles, inverse);
+    free(twiddles);
+}
+
+void fft2D(double *signal, int rows, int columns, int inverse)
+{
+    double *rowTwiddles = fftTwiddles(columns);
+    double *columnTwiddles = fftTwiddles(rows);
+    for (int i = 0; i < rows; i++)
+        fftWithTwiddles(signal + 2 * (size_t)i * columns, columns, rowTwiddles, inverse);
+
+    double *column = (double *)malloc(2 * rows * sizeof(double));
+    checkMalloc(column, "FFT column");
+    for (int j = 0; j < columns; j++)
+    {
+        for (int i = 0; i < rows; i++)
+        {
+            column[2 * i] = signal[2 * ((size_t)i * columns + j)];
+            column[2 * i + 1] = signal[2 * ((size_t)i * columns + j) + 1];
+        }
+        fftWithTwiddles(column, rows, columnTwiddles, inverse);
+        for (int i = 0; i < rows; i++)
+        {
+            signal[2 * ((size_t)i * columns + j)] = column[2 * i];
+            signal[2 * ((size_t)i * columns + j) + 1] = column[2 * i + 1];
+        }
+    }
+    free(column);
+    free(rowTwiddles);
+    free(columnTwiddles);
+}
+
+int fftLength(int n)
+{
+    int length = 1;
+    while (length < n)
+        length <<= 1;
+    return length;
+}
+
+int fftPaysOff(Picture *picture, Object *object)
+{
+    double positions = (double)(picture->width - object->width + 1) * (picture->height - object->height + 1);
+    double size = (double)fftLength(picture->width) * fftLength(picture->height);
+    // one object, FFT_COLOR_BANDS / 2 picture and FFT_COLOR_BANDS / 2 inverse transforms
+    double butterflies = (FFT_COLOR_BANDS + 1) * size * log2(size) / 2;
+    return positions * object->width * object->height > FFT_COST_FACTOR * butterflies;
+}
+
+static int colorBand(int color)
+{
+    int band = 0;
+    while (band < FFT_COLOR_BANDS - 1 && color > bandLimits[band])
+        band++;
+    return band;
+}
+
+int matchingLowerBounds(Picture *picture, Object *object, double *lowerBounds)
+{
+    int rows = fftLength(picture->height), columns = fftLength(picture->width);
+    int positionRows = picture->height - object->height + 1;
+    int positionColumns = picture->width - object->width + 1;
+    size_t size = (size_t)rows * columns;
+    int integralColumns = picture->width + 1;
+
+    for (int i = 0; i < picture->height; i++)
+        for (int j = 0; j < picture->width; j++)
+            if (picture->colorsMatrix[i * picture->pitch + j] < 0)
+                return 0;
+
+    // band k of 1 / P goes to the real part of transform k / 2 for even k and to the imaginary part for odd k,
+    // the band members are counted with one integral image per band
+    double *pictureTransforms = (double *)calloc(FFT_COLOR_BANDS / 2 * 2 * size, sizeof(double));
+    double *objectTransform = (double *)calloc(2 * size, sizeof(double));
+    int *integralCounts = (int *)calloc((size_t)FFT_COLOR_BANDS * (picture->height + 1) * integralColumns, sizeof(int));
+    checkMalloc(pictureTransforms, "FFT picture transforms");
+    checkMalloc(objectTransform, "FFT object transform");
+    checkMalloc(integralCounts, "FFT band counts");
+
+    double inverseNormSquared = 0;
+    for (int i = 0; i < picture->height; i++)
+        for (int j = 0; j < picture->width; j++)
+        {
+            int color = picture->colorsMatrix[i * picture->pitch + j];
+            int band = colorBand(color);
+            if (color != 0)
+            {
+                pictureTransforms[(band / 2) * 2 * size + 2 * ((size_t)i * columns + j) + band % 2] = 1.0 / color;
+                inverseNormSquared += 1.0 / ((double)color * color);
+            }
+            for (int k = 0; k < FFT_COLOR_BANDS; k++)
+            {
+                int *counts = integralCounts + (size_t)k * (picture->height + 1) * integralColumns;
+                counts[(i + 1) * integralColumns + j + 1] = counts[i * integralColumns + j + 1] + counts[(i + 1) * integralColumns + j] -
+                                                            counts[i * integralColumns + j] + (color != 0 && band == k);
+            }
+        }
+
+    double objectNorm = 0;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            objectTransform[2 * ((size_t)i * columns + j)] = object->subColorsMatrix[i * object->pitch + j];
+            objectNorm += fabs((double)object->subColorsMatrix[i * object->pitch + j]);
+        }
+
+    // the correlation of a picture band with the object is the inverse transform of its transform times the conjugate object transform
+    fft2D(objectTransform, rows, columns, 0);
+    for (int t = 0; t < FFT_COLOR_BANDS / 2; t++)
+    {
+        double *transform = pictureTransforms + t * 2 * size;
+        fft2D(transform, rows, columns, 0);
+        for (size_t i = 0; i < size; i++)
+        {
+            double re = transform[2 * i], im = transform[2 * i + 1];
+            double oRe = objectTransform[2 * i], oIm = -objectTransform[2 * i + 1];
+            transform[2 * i] = (re * oRe - im * oIm) / size;
+            transform[2 * i + 1] = (re * oIm + im * oRe) / size;
+        }
+        fft2D(transform, rows, columns, 1);
+    }
+
+    // the error of an FFT correlation is at most a small multiple of eps * log2(size) * ||1 / P||_2 * ||O||_1
+    double area = (double)object->width * object->height;
+    double correlationError = FFT_ERROR_FACTOR * DBL_EPSILON * log2((double)size) * sqrt(inverseNormSquared) * objectNorm;
+    double summationError = (area + 4) * DBL_EPSILON;
+
+    for (int r = 0; r < positionRows; r++)
+        for (int c = 0; c < positionColumns; c++)
+        {
+            double bound = 0;
+            for (int k = 0; k < FFT_COLOR_BANDS; k++)
+            {
+                int *counts = integralCounts + (size_t)k * (picture->height + 1) * integralColumns;
+                int r2 = r + object->height, c2 = c + object->width;
+                int members = counts[r2 * integralColumns + c2] - counts[r * integralColumns + c2] - counts[r2 * integralColumns + c] + counts[r * integralColumns + c];
+                double correlation = pictureTransforms[(k / 2) * 2 * size + 2 * ((size_t)r * columns + c) + k % 2];
+                bound += fabs(members - correlation);
+            }
+            bound -= FFT_COLOR_BANDS * correlationError;
+            lowerBounds[r * positionColumns + c] = bound > 0 ? bound * (1 - summationError) / area : 0;
+        }
+
+    free(pictureTransforms);
+    free(objectTransform);
+    free(integralCounts);
+    return 1;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "helper.h"
+
+#define FFT_COLOR_BANDS 4 // even, two bands share one complex transform
+#define FFT_ERROR_FACTOR 64
+#define FFT_COST_FACTOR 60 // direct comparisons per FFT butterfly at which the prefilter pays off
+
+/*
+ * This function transforms a complex signal in place with an iterative radix-2 FFT
+ * @param signal: the signal, interleaved real and imaginary parts
+ * @param length: the number of complex values, a power of 2
+ * @param inverse: 1 for the inverse transform, which is not scaled by 1 / length
+ * @return: void
+ */
+void fft(double *signal, int length, int inverse);
+
+/*
+ * This function transforms a complex matrix in place, the rows first and then the columns
+ * @param signal: the matrix, interleaved real and imaginary parts row by row
+ * @param rows: the number of rows, a power of 2
+ * @param columns: the number of columns, a power of 2
+ * @param inverse: 1 for the inverse transform, which is not scaled by 1 / (rows * columns)
+ * @return: void
+ */
+void fft2D(double *signal, int rows, int columns, int inverse);
+
+/*
+ * This function returns the smallest power of 2 that is at least n
+ * @param n: the size
+ * @return: the power of 2
+ */
+int fftLength(int n);
+
+/*
+ * This function estimates whether the FFT prefilter is cheaper than evaluating every position directly
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @return: 1 if the prefilter pays off, 0 otherwise
+ */
+int fftPaysOff(Picture *picture, Object *object);
+
+/*
+ * This function computes a lower bound of the matching value of every position at once.
+ * The picture colors are split into FFT_COLOR_BANDS bands, and for every band the sum of (P - O) / P
+ * over the window is the number of band members minus the correlation of 1 / P with O, computed with FFTs.
+ * Since abs((P - O) / P) = abs(1 - O / P) for P > 0, the sum of the absolute band sums is a lower bound.
+ * The bounds are lowered by the rounding error of the FFTs and of the direct summation, so a position
+ * whose bound reaches the threshold cannot match in any backend.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param lowerBounds: the lower bound of every position, (height - object height + 1) rows of (width - object width + 1)
+ * @return: 1 if the bounds were computed, 0 if the picture has negative colors and the bound does not hold
+ */
+int matchingLowerBounds(Picture *picture, Object *object, double *lowerBounds);
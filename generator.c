@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "helper.h"
+
+#define DEFAULT_GENERATED_FILE "generated.txt"
+#define DEFAULT_TRUTH_FILE "ground_truth.txt"
+#define MAX_PLANT_ATTEMPTS 16
+
+struct SizeRangeStruct
+{
+    int numberOfSizes; // 0 for a uniform range between min and max
+    int min;
+    int max;
+    int *sizes;
+};
+typedef struct SizeRangeStruct SizeRange;
+
+struct GeneratorOptionsStruct
+{
+    const char *outputFile;
+    const char *truthFile;
+    int binary;
+    int numberOfPictures;
+    int numberOfObjects;
+    SizeRange pictureSizes;
+    SizeRange pictureHeights; // min 0 for square pictures
+    SizeRange objectSizes;
+    SizeRange objectHeights; // min 0 for square objects
+    double density;
+    int noise;
+    double matchingThreshold;
+    unsigned long long seed;
+};
+typedef struct GeneratorOptionsStruct GeneratorOptions;
+
+static unsigned long long randomState;
+
+/*
+ * xorshift64* generator, so a seed gives the same dataset on every platform
+ * @return: the next random number
+ */
+static unsigned long long nextRandom(void)
+{
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return randomState * 2685821657736338717ULL;
+}
+
+static int randomInt(int min, int max)
+{
+    return min + (int)(nextRandom() % (unsigned long long)(max - min + 1));
+}
+
+static double randomDouble(void)
+{
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void fail(const char *message, const char *detail)
+{
+    fprintf(stderr, "Error: %s %s\n", message, detail);
+    exit(1);
+}
+
+static void *checkedMalloc(size_t size, const char *message)
+{
+    void *ptr = malloc(size);
+    if (ptr == NULL)
+        fail("allocating memory for", message);
+    return ptr;
+}
+
+/*
+ * This function parses a size distribution, either a uniform range "min:max", a single size or a list "a,b,c"
+ * @param text: the size distribution
+ * @param range: the parsed size distribution
+ * @return: void
+ */
+static void parseSizeRange(const char *text, SizeRange *range)
+{
+    range->numberOfSizes = 0;
+    range->sizes = NULL;
+    if (strchr(text, ',') != NULL)
+    {
+        range->sizes = (int *)checkedMalloc((strlen(text) / 2 + 1) * sizeof(int), "size list");
+        for (const char *p = text; p != NULL; p = strchr(p, ','))
+        {
+            if (*p == ',')
+                p++;
+            range->sizes[range->numberOfSizes++] = atoi(p);
+        }
+        range->min = range->max = range->sizes[0];
+        for (int i = 0; i < range->numberOfSizes; i++)
+        {
+            range->min = range->sizes[i] < range->min ? range->sizes[i] : range->min;
+            range->max = range->sizes[i] > range->max ? range->sizes[i] : range->max;
+        }
+    }
+    else if (sscanf(text, "%d:%d", &range->min, &range->max) != 2)
+        range->max = range->min = atoi(text);
+    if (range->min < 1 || range->max < range->min)
+        fail("invalid size distribution", text);
+}
+
+static int randomSize(SizeRange *range)
+{
+    if (range->min == 0)
+        return 0;
+    if (range->numberOfSizes > 0)
+        return range->sizes[randomInt(0, range->numberOfSizes - 1)];
+    return randomInt(range->min, range->max);
+}
+
+static void parseGeneratorOptions(int argc, char *argv[], GeneratorOptions *options)
+{
+    options->outputFile = DEFAULT_GENERATED_FILE;
+    options->truthFile = DEFAULT_TRUTH_FILE;
+    options->binary = 0;
+    options->numberOfPictures = 100;
+    options->numberOfObjects = 8;
+    parseSizeRange("100:400", &options->pictureSizes);
+    parseSizeRange("10:40", &options->objectSizes);
+    memset(&options->pictureHeights, 0, sizeof(SizeRange));
+    memset(&options->objectHeights, 0, sizeof(SizeRange));
+    options->density = 0.5;
+    options->noise = 0;
+    options->matchingThreshold = 0.1;
+    options->seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 >= argc)
+            fail("missing value for option", argv[i]);
+        if (strcmp(argv[i], "--output") == 0)
+            options->outputFile = argv[++i];
+        else if (strcmp(argv[i], "--truth") == 0)
+            options->truthFile = argv[++i];
+        else if (strcmp(argv[i], "--format") == 0)
+            options->binary = strcmp(argv[++i], "binary") == 0;
+        else if (strcmp(argv[i], "--pictures") == 0)
+            options->numberOfPictures = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--objects") == 0)
+            options->numberOfObjects = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--picture-size") == 0)
+            parseSizeRange(argv[++i], &options->pictureSizes);
+        else if (strcmp(argv[i], "--object-size") == 0)
+            parseSizeRange(argv[++i], &options->objectSizes);
+        else if (strcmp(argv[i], "--picture-height") == 0)
+            parseSizeRange(argv[++i], &options->pictureHeights);
+        else if (strcmp(argv[i], "--object-height") == 0)
+            parseSizeRange(argv[++i], &options->objectHeights);
+        else if (strcmp(argv[i], "--density") == 0)
+            options->density = atof(argv[++i]);
+        else if (strcmp(argv[i], "--noise") == 0)
+            options->noise = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0)
+            options->matchingThreshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0)
+            options->seed = strtoull(argv[++i], NULL, 10);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--output file] [--truth file] [--format text|binary] [--pictures n] [--objects n]\n"
+                            "       [--picture-size min:max|a,b,c] [--object-size min:max|a,b,c] [--picture-height min:max|a,b,c]\n"
+                            "       [--object-height min:max|a,b,c] [--density p] [--noise n]\n"
+                            "       [--threshold t] [--seed s]\n",
+                    argv[0]);
+            exit(1);
+        }
+    }
+    if (options->numberOfPictures < 1 || options->numberOfObjects < 1)
+        fail("invalid number of", "pictures or objects");
+    // the text input format has a single dimension per picture and object
+    if (!options->binary && (options->pictureHeights.min > 0 || options->objectHeights.min > 0))
+        fail("rectangular pictures and objects need", "--format binary");
+    randomState = options->seed * 0x9E3779B97F4A7C15ULL + 1;
+}
+
+static void fillRandomColors(int *colors, int numberOfColors)
+{
+    for (int i = 0; i < numberOfColors; i++)
+        colors[i] = randomInt(MIN_COLOR, MAX_COLOR);
+}
+
+/*
+ * This function copies an object into a picture, adding uniform noise of at most noise to every color
+ * @return: void
+ */
+static void plantObject(Picture *picture, Object *object, int row, int column, int noise)
+{
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int color = object->subColorsMatrix[i * object->pitch + j];
+            if (noise > 0)
+                color += randomInt(-noise, noise);
+            color = color < MIN_COLOR ? MIN_COLOR : color > MAX_COLOR ? MAX_COLOR : color;
+            picture->colorsMatrix[(row + i) * picture->pitch + (column + j)] = color;
+        }
+}
+
+/*
+ * The matching score of the search, computed the same way as the kernels do
+ * @return: the average of abs((P - O) / P) over the overlapping members
+ */
+static double plantedScore(Picture *picture, Object *object, int row, int column)
+{
+    double res = 0;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int objectColor = object->subColorsMatrix[i * object->pitch + j];
+            int pictureColor = picture->colorsMatrix[(row + i) * picture->pitch + (column + j)];
+            if (pictureColor != 0)
+                res += (double)abs(pictureColor - objectColor) / pictureColor;
+        }
+    return res / (object->width * object->height);
+}
+
+static int overlaps(Position *planted, Object **plantedObjects, int numberOfPlanted, int row, int column, Object *object)
+{
+    for (int k = 0; k < numberOfPlanted; k++)
+        if (row < planted[k].row + plantedObjects[k]->height && planted[k].row < row + object->height &&
+            column < planted[k].column + plantedObjects[k]->width && planted[k].column < column + object->width)
+            return 1;
+    return 0;
+}
+
+/*
+ * This function writes a picture or object, the generated matrices have no row padding
+ * @return: void
+ */
+static void writeElement(FILE *fp, int binary, int ID, int width, int height, int *colors)
+{
+    if (binary)
+    {
+        fwrite(&ID, sizeof(int), 1, fp);
+        fwrite(&width, sizeof(int), 1, fp);
+        fwrite(&height, sizeof(int), 1, fp);
+        fwrite(colors, sizeof(int), (size_t)width * height, fp);
+        return;
+    }
+    fprintf(fp, "%d\n%d\n", ID, width);
+    for (int i = 0; i < height; i++)
+    {
+        for (int j = 0; j < width; j++)
+            fprintf(fp, "%4d", colors[i * width + j]);
+        fprintf(fp, "\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    GeneratorOptions options;
+    parseGeneratorOptions(argc, argv, &options);
+
+    // objects are generated first, so they can be planted into the pictures
+    Object *objects = (Object *)checkedMalloc(options.numberOfObjects * sizeof(Object), "objects array");
+    for (int i = 0; i < options.numberOfObjects; i++)
+    {
+        objects[i].ID = i + 1;
+        objects[i].width = objects[i].pitch = randomSize(&options.objectSizes);
+        objects[i].height = options.objectHeights.min > 0 ? randomSize(&options.objectHeights) : objects[i].width;
+        objects[i].subColorsMatrix = (int *)checkedMalloc(objects[i].width * objects[i].height * sizeof(int), "colors matrix of object");
+        fillRandomColors(objects[i].subColorsMatrix, objects[i].width * objects[i].height);
+    }
+
+    FILE *fp = fopen(options.outputFile, options.binary ? "wb" : "w");
+    if (fp == NULL)
+        fail("opening", options.outputFile);
+    FILE *truth = fopen(options.truthFile, "w");
+    if (truth == NULL)
+        fail("opening", options.truthFile);
+
+    if (options.binary)
+    {
+        InputFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, INPUT_FILE_MAGIC, sizeof(header.magic));
+        header.version = INPUT_FILE_VERSION;
+        header.matchingThreshold = options.matchingThreshold;
+        header.numberOfPictures = options.numberOfPictures;
+        fwrite(&header, sizeof(header), 1, fp);
+    }
+    else
+        fprintf(fp, "%.17g\n%d\n", options.matchingThreshold, options.numberOfPictures);
+
+    fprintf(truth, "# seed %llu, threshold %.17g\n", options.seed, options.matchingThreshold);
+    fprintf(truth, "# picture object row column score below_threshold\n");
+
+    Position *planted = (Position *)checkedMalloc(options.numberOfObjects * sizeof(Position), "planted positions");
+    Object **plantedObjects = (Object **)checkedMalloc(options.numberOfObjects * sizeof(Object *), "planted objects");
+    long numberOfPlantedTotal = 0;
+
+    // pictures are generated one at a time, so datasets larger than memory can be written
+    for (int p = 0; p < options.numberOfPictures; p++)
+    {
+        Picture picture;
+        int numberOfPlanted = 0;
+        picture.ID = p + 1;
+        picture.width = picture.pitch = randomSize(&options.pictureSizes);
+        picture.height = options.pictureHeights.min > 0 ? randomSize(&options.pictureHeights) : picture.width;
+        picture.colorsMatrix = (int *)checkedMalloc((size_t)picture.width * picture.height * sizeof(int), "colors matrix of picture");
+        fillRandomColors(picture.colorsMatrix, picture.width * picture.height);
+
+        for (int i = 0; i < options.numberOfObjects; i++)
+        {
+            Object *object = &objects[i];
+            if (object->width > picture.width || object->height > picture.height || randomDouble() >= options.density)
+                continue;
+            for (int attempt = 0; attempt < MAX_PLANT_ATTEMPTS; attempt++)
+            {
+                int row = randomInt(0, picture.height - object->height);
+                int column = randomInt(0, picture.width - object->width);
+                if (overlaps(planted, plantedObjects, numberOfPlanted, row, column, object))
+                    continue;
+                plantObject(&picture, object, row, column, options.noise);
+                planted[numberOfPlanted].row = row;
+                planted[numberOfPlanted].column = column;
+                plantedObjects[numberOfPlanted] = object;
+                numberOfPlanted++;
+                break;
+            }
+        }
+
+        for (int k = 0; k < numberOfPlanted; k++)
+        {
+            double score = plantedScore(&picture, plantedObjects[k], planted[k].row, planted[k].column);
+            fprintf(truth, "%d %d %d %d %.17g %d\n", picture.ID, plantedObjects[k]->ID, planted[k].row, planted[k].column,
+                    score, score < options.matchingThreshold);
+        }
+        numberOfPlantedTotal += numberOfPlanted;
+
+        writeElement(fp, options.binary, picture.ID, picture.width, picture.height, picture.colorsMatrix);
+        free(picture.colorsMatrix);
+    }
+
+    if (options.binary)
+        fwrite(&options.numberOfObjects, sizeof(int), 1, fp);
+    else
+        fprintf(fp, "%d\n", options.numberOfObjects);
+    for (int i = 0; i < options.numberOfObjects; i++)
+        writeElement(fp, options.binary, objects[i].ID, objects[i].width, objects[i].height, objects[i].subColorsMatrix);
+
+    fclose(fp);
+    fclose(truth);
+    printf("Generated %d pictures and %d objects with %ld planted objects into %s, ground truth in %s\n",
+           options.numberOfPictures, options.numberOfObjects, numberOfPlantedTotal, options.outputFile, options.truthFile);
+
+    free(planted);
+    free(plantedObjects);
+    for (int i = 0; i < options.numberOfObjects; i++)
+        free(objects[i].subColorsMatrix);
+    free(objects);
+    free(options.pictureSizes.sizes);
+    free(options.objectSizes.sizes);
+    free(options.pictureHeights.sizes);
+    free(options.objectHeights.sizes);
+    return 0;
+}
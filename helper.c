@@ -2,10 +2,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <math.h>
 #include <time.h>
 #include <omp.h>
 #include "helper.h"
+#include "cpuHelper.h"
+#include "arenaHelper.h"
+#include "numaHelper.h"
+#include "trace.h"
 
 void freePictures(Picture *pictures, int numPictures)
 {
@@ -17,7 +22,11 @@ void freePictures(Picture *pictures, int numPictures)
 void freeObjects(Object *objects, int numObjects)
 {
     for (int i = 0; i < numObjects; i++)
+    {
         free(objects[i].subColorsMatrix);
+        free(objects[i].colorCounts);
+        free(objects[i].visitBlocks);
+    }
     free(objects);
 }
 
@@ -27,10 +36,92 @@ void freeLogs(Logs *logs, int numLogs)
     {
         free(logs[i].objectIDs);
         free(logs[i].objectPositions);
+        free(logs[i].objectScores);
+        free(logs[i].objectTimes);
+        free(logs[i].objectOrientations);
     }
     free(logs);
 }
 
+int rowPitch(int width)
+{
+    return (width + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+}
+
+int *allocateColorsMatrix(int width, int height, int *pitch)
+{
+    void *colorsMatrix = NULL;
+    *pitch = rowPitch(width);
+    size_t size = (size_t)*pitch * height * sizeof(int);
+    if (allocateAligned(&colorsMatrix, ROW_ALIGNMENT * sizeof(int), size > 0 ? size : sizeof(int)) != 0)
+        return NULL;
+    memset(colorsMatrix, 0, size);
+    return (int *)colorsMatrix;
+}
+
+void allocateLogArrays(Logs *log, int capacity, Arena *arena)
+{
+    // one extra member, so a log without objects still gets valid arrays
+    if (arena != NULL)
+    {
+        log->objectIDs = (int *)arenaAllocate(arena, (capacity + 1) * sizeof(int));
+        log->objectPositions = (Position *)arenaAllocate(arena, (capacity + 1) * sizeof(Position));
+        log->objectScores = (double *)arenaAllocate(arena, (capacity + 1) * sizeof(double));
+        log->objectTimes = (double *)arenaAllocate(arena, (capacity + 1) * sizeof(double));
+        log->objectOrientations = (int *)arenaAllocate(arena, (capacity + 1) * sizeof(int));
+        return;
+    }
+    log->objectIDs = (int *)malloc((capacity + 1) * sizeof(int));
+    checkMalloc(log->objectIDs, "object IDs array");
+    log->objectPositions = (Position *)malloc((capacity + 1) * sizeof(Position));
+    checkMalloc(log->objectPositions, "object positions array");
+    log->objectScores = (double *)malloc((capacity + 1) * sizeof(double));
+    checkMalloc(log->objectScores, "object scores array");
+    log->objectTimes = (double *)malloc((capacity + 1) * sizeof(double));
+    checkMalloc(log->objectTimes, "object times array");
+    log->objectOrientations = (int *)malloc((capacity + 1) * sizeof(int));
+    checkMalloc(log->objectOrientations, "object orientations array");
+}
+
+void allocatePicture(Picture *picture, int width, int height)
+{
+    picture->width = width;
+    picture->height = height;
+    picture->colorsMatrix = allocateColorsMatrix(width, height, &picture->pitch);
+    checkMalloc(picture->colorsMatrix, "colors matrix of picture");
+}
+
+void allocateObject(Object *object, int width, int height)
+{
+    object->width = width;
+    object->height = height;
+    object->subColorsMatrix = allocateColorsMatrix(width, height, &object->pitch);
+    object->colorCounts = NULL;
+    object->visitBlocks = NULL;
+    checkMalloc(object->subColorsMatrix, "colors matrix of object");
+}
+
+void computeColorCounts(Object *object)
+{
+    object->colorCounts = NULL;
+    int *colorCounts = (int *)calloc(HISTOGRAM_COLORS, sizeof(int));
+    checkMalloc(colorCounts, "color counts of object");
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int color = object->subColorsMatrix[i * object->pitch + j];
+            if (color < 0 || color >= HISTOGRAM_COLORS)
+            {
+                free(colorCounts);
+                return;
+            }
+            colorCounts[color]++;
+        }
+    for (int c = 1; c < HISTOGRAM_COLORS; c++)
+        colorCounts[c] += colorCounts[c - 1];
+    object->colorCounts = colorCounts;
+}
+
 void checkRead(int read, int expected, const char *message)
 {
     if (read != expected)
@@ -49,109 +140,689 @@ void checkMalloc(void *ptr, const char *message)
     }
 }
 
-void readColorsMatrix(FILE *fp, int *colorsMatrix, int dimension)
+/*
+ * The number of bytes after the current position of a file, which bounds the number of colors still to read
+ */
+static long long remainingBytes(FILE *fp)
 {
-    for (int j = 0; j < dimension; j++)
-        for (int k = 0; k < dimension; k++)
-            checkRead(fscanf(fp, "%d", &colorsMatrix[j * dimension + k]), 1, "color");
+    long position = ftell(fp);
+    struct stat fileStatus;
+    if (position < 0 || fstat(fileno(fp), &fileStatus) != 0)
+        return 0;
+    return (long long)fileStatus.st_size - position;
 }
 
-void readPictures(FILE *fp, Picture **pictures, int *numberOfPictures)
+const char *readColorsMatrix(FILE *fp, int *colorsMatrix, int width, int height, int pitch)
 {
-    // read number of pictures
-    checkRead(fscanf(fp, "%d", numberOfPictures), 1, "number of pictures");
+    for (int j = 0; j < height; j++)
+        for (int k = 0; k < width; k++)
+            if (fscanf(fp, "%d", &colorsMatrix[j * pitch + k]) != 1)
+                return "color";
+    return NULL;
+}
+
+const char *readPictures(FILE *fp, Picture **pictures, int *numberOfPictures)
+{
+    // read number of pictures, every picture takes a few characters of the file at least
+    int count;
+    *numberOfPictures = 0;
+    *pictures = NULL;
+    if (fscanf(fp, "%d", &count) != 1 || count < 0 || count > remainingBytes(fp))
+        return "number of pictures";
 
     // allocate memory for pictures array
-    *pictures = (Picture *)malloc(*numberOfPictures * sizeof(Picture));
+    *pictures = (Picture *)malloc((count + 1) * sizeof(Picture));
     checkMalloc(*pictures, "pictures array");
 
     // read pictures from file and store them in pictures array of Picture structs
-    for (int i = 0; i < *numberOfPictures; i++)
+    for (int i = 0; i < count; i++)
     {
         // read picture ID
-        checkRead(fscanf(fp, "%d", &(*pictures)[i].ID), 1, "picture ID");
+        if (fscanf(fp, "%d", &(*pictures)[i].ID) != 1)
+            return "picture ID";
 
-        // read picture dimension
-        checkRead(fscanf(fp, "%d", &(*pictures)[i].dimension), 1, "picture dimension");
+        // read picture dimension, pictures of the text format are square
+        int dimension;
+        if (fscanf(fp, "%d", &dimension) != 1 || dimension < 0 || (long long)dimension * dimension > remainingBytes(fp))
+            return "picture dimension";
 
-        // allocate memory for colors matrix
-        (*pictures)[i].colorsMatrix = (int *)malloc((*pictures)[i].dimension * (*pictures)[i].dimension * sizeof(int));
-        checkMalloc((*pictures)[i].colorsMatrix, "colors matrix of picture");
-        readColorsMatrix(fp, (*pictures)[i].colorsMatrix, (*pictures)[i].dimension);
+        // allocate memory for colors matrix, the picture is freed with the others from now on
+        allocatePicture(&(*pictures)[i], dimension, dimension);
+        (*numberOfPictures)++;
+        const char *error = readColorsMatrix(fp, (*pictures)[i].colorsMatrix, dimension, dimension, (*pictures)[i].pitch);
+        if (error != NULL)
+            return error;
     }
+    return NULL;
 }
 
-void readObjects(FILE *fp, Object **objects, int *numberOfObjects)
+const char *readObjects(FILE *fp, Object **objects, int *numberOfObjects)
 {
     // read number of objects
-    checkRead(fscanf(fp, "%d", numberOfObjects), 1, "number of objects");
+    int count;
+    *numberOfObjects = 0;
+    *objects = NULL;
+    if (fscanf(fp, "%d", &count) != 1 || count < 0 || count > remainingBytes(fp))
+        return "number of objects";
 
     // allocate memory for objects array
-    *objects = (Object *)malloc(*numberOfObjects * sizeof(Object));
+    *objects = (Object *)malloc((count + 1) * sizeof(Object));
     checkMalloc(*objects, "objects array");
 
     // read objects from file and store them in objects array of Object structs
-    for (int i = 0; i < *numberOfObjects; i++)
+    for (int i = 0; i < count; i++)
     {
         // read object ID
-        checkRead(fscanf(fp, "%d", &(*objects)[i].ID), 1, "object ID");
+        if (fscanf(fp, "%d", &(*objects)[i].ID) != 1)
+            return "object ID";
 
-        // read object dimension
-        checkRead(fscanf(fp, "%d", &(*objects)[i].dimension), 1, "object dimension");
+        // read object dimension, objects of the text format are square
+        int dimension;
+        if (fscanf(fp, "%d", &dimension) != 1 || dimension < 0 || (long long)dimension * dimension > remainingBytes(fp))
+            return "object dimension";
 
         // allocate memory for colors matrix
-        (*objects)[i].subColorsMatrix = (int *)malloc((*objects)[i].dimension * (*objects)[i].dimension * sizeof(int));
-        checkMalloc((*objects)[i].subColorsMatrix, "colors matrix of object");
-        readColorsMatrix(fp, (*objects)[i].subColorsMatrix, (*objects)[i].dimension);
+        allocateObject(&(*objects)[i], dimension, dimension);
+        (*numberOfObjects)++;
+        const char *error = readColorsMatrix(fp, (*objects)[i].subColorsMatrix, dimension, dimension, (*objects)[i].pitch);
+        if (error != NULL)
+            return error;
     }
+    return NULL;
+}
+
+/*
+ * This function reads the size and the colors of a picture or object from a binary input file
+ * @return: NULL, or what could not be read
+ */
+static const char *readBinaryColors(FILE *fp, int isSquare, int **colorsMatrix, int *width, int *height, int *pitch)
+{
+    *colorsMatrix = NULL;
+    if (fread(width, sizeof(int), 1, fp) != 1)
+        return "width";
+    if (isSquare)
+        *height = *width;
+    else if (fread(height, sizeof(int), 1, fp) != 1)
+        return "height";
+    if (*width < 0 || *height < 0 || (long long)*width * *height * (long long)sizeof(int) > remainingBytes(fp))
+        return "size";
+    *colorsMatrix = allocateColorsMatrix(*width, *height, pitch);
+    checkMalloc(*colorsMatrix, "colors matrix");
+    for (int j = 0; j < *height; j++)
+        if (fread(*colorsMatrix + j * *pitch, sizeof(int), *width, fp) != (size_t)*width)
+            return "colors";
+    return NULL;
+}
+
+const char *readBinaryInput(FILE *fp, Picture **pictures, Object **objects, int *numberOfPictures, int *numberOfObjects, int isSquare)
+{
+    int count = *numberOfPictures;
+    const char *error = NULL;
+    *numberOfPictures = 0;
+    *numberOfObjects = 0;
+    *pictures = NULL;
+    *objects = NULL;
+    // every picture takes an ID and a size at least
+    if (count < 0 || count > remainingBytes(fp) / (long long)(2 * sizeof(int)))
+        return "number of pictures";
+    *pictures = (Picture *)malloc((count + 1) * sizeof(Picture));
+    checkMalloc(*pictures, "pictures array");
+    for (int i = 0; i < count; i++)
+    {
+        Picture *picture = &(*pictures)[i];
+        if (fread(&picture->ID, sizeof(int), 1, fp) != 1)
+            return "picture ID";
+        error = readBinaryColors(fp, isSquare, &picture->colorsMatrix, &picture->width, &picture->height, &picture->pitch);
+        if (picture->colorsMatrix != NULL)
+            (*numberOfPictures)++;
+        if (error != NULL)
+            return error;
+    }
+
+    if (fread(&count, sizeof(int), 1, fp) != 1 || count < 0 || count > remainingBytes(fp) / (long long)(2 * sizeof(int)))
+        return "number of objects";
+    *objects = (Object *)malloc((count + 1) * sizeof(Object));
+    checkMalloc(*objects, "objects array");
+    for (int i = 0; i < count; i++)
+    {
+        Object *object = &(*objects)[i];
+        if (fread(&object->ID, sizeof(int), 1, fp) != 1)
+            return "object ID";
+        object->colorCounts = NULL;
+        object->visitBlocks = NULL;
+        error = readBinaryColors(fp, isSquare, &object->subColorsMatrix, &object->width, &object->height, &object->pitch);
+        if (object->subColorsMatrix != NULL)
+            (*numberOfObjects)++;
+        if (error != NULL)
+            return error;
+    }
+    return NULL;
+}
+
+const char *parseInputFile(const char *inputFile, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects)
+{
+    InputFileHeader header;
+    const char *error;
+    *pictures = NULL;
+    *objects = NULL;
+    *numberOfPictures = 0;
+    *numberOfObjects = 0;
+    FILE *fp = fopen(inputFile, "rb");
+    if (fp == NULL)
+        return inputFile;
+
+    // binary input files start with a magic, anything else is read as text
+    if (fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, INPUT_FILE_MAGIC, sizeof(header.magic)) == 0)
+    {
+        *matchingThreshold = header.matchingThreshold;
+        *numberOfPictures = header.numberOfPictures;
+        if (header.version != SQUARE_INPUT_FILE_VERSION && header.version != INPUT_FILE_VERSION)
+            error = "input file version";
+        else
+            error = readBinaryInput(fp, pictures, objects, numberOfPictures, numberOfObjects, header.version == SQUARE_INPUT_FILE_VERSION);
+    }
+    else
+    {
+        rewind(fp);
+        if (fscanf(fp, "%lf", matchingThreshold) != 1)
+            error = "matching threshold";
+        else if ((error = readPictures(fp, pictures, numberOfPictures)) == NULL)
+            error = readObjects(fp, objects, numberOfObjects);
+    }
+    fclose(fp);
+
+    // a partly read input is released, the pictures and objects read completely or partly are counted
+    if (error != NULL)
+    {
+        if (*pictures != NULL)
+            freePictures(*pictures, *numberOfPictures);
+        if (*objects != NULL)
+            freeObjects(*objects, *numberOfObjects);
+        *pictures = NULL;
+        *objects = NULL;
+        *numberOfPictures = 0;
+        *numberOfObjects = 0;
+    }
+    return error;
 }
 
 void readInputFile(const char *inputFile, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects)
 {
-    FILE *fp = fopen(inputFile, "r");
-    checkMalloc(fp, "file pointer");
-    checkRead(fscanf(fp, "%lf", matchingThreshold), 1, "matching threshold");
-    readPictures(fp, pictures, numberOfPictures);
-    readObjects(fp, objects, numberOfObjects);
+    const char *error = parseInputFile(inputFile, pictures, objects, matchingThreshold, numberOfPictures, numberOfObjects);
+    if (error != NULL)
+        checkRead(0, 1, error);
+}
+
+void parseOptions(int argc, char *argv[], Options *options)
+{
+    options->inputFile = INPUT_FILE;
+    options->parallelOutput = 0;
+    options->resultFormat = RESULT_FORMAT_TEXT;
+    options->trace = 0;
+    options->backend = DEFAULT_BACKEND;
+    options->numThreads = 0;
+    options->matchingThreshold = -1;
+    options->numberOfImagePaths = 0;
+    options->numberOfObjectImagePaths = 0;
+    options->numberOfObjectCrops = 0;
+    options->spoolDirectory = NULL;
+    options->objectSnapshot = NULL;
+    options->saveObjectSnapshot = NULL;
+    options->cacheDirectory = NULL;
+    options->cacheMegabytes = DEFAULT_CACHE_MEGABYTES;
+    options->scoreMapDirectory = NULL;
+    options->numberOfThresholds = 0;
+    options->numa = 0;
+    options->dispatchOrder = DISPATCH_INPUT_ORDER;
+    options->batchPictures = 0;
+    options->splitPictures = 0;
+    options->orientations = 0;
+    options->maskObjects = 0;
+    options->transparentColor = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            options->inputFile = argv[++i];
+        else if (strcmp(argv[i], "--parallel-output") == 0)
+            options->parallelOutput = 1;
+        else if (strcmp(argv[i], "--trace") == 0)
+            options->trace = 1;
+        else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc)
+        {
+            options->backend = argv[++i];
+            if (findMatchingBackend(options->backend) == NULL)
+            {
+                printf("Unknown backend %s \r \n", options->backend);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            options->numThreads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            options->matchingThreshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--images") == 0 && i + 1 < argc && options->numberOfImagePaths < MAX_OPTION_PATHS)
+            options->imagePaths[options->numberOfImagePaths++] = argv[++i];
+        else if (strcmp(argv[i], "--object-images") == 0 && i + 1 < argc && options->numberOfObjectImagePaths < MAX_OPTION_PATHS)
+            options->objectImagePaths[options->numberOfObjectImagePaths++] = argv[++i];
+        else if (strcmp(argv[i], "--crop-object") == 0 && i + 1 < argc && options->numberOfObjectCrops < MAX_OPTION_PATHS)
+            options->objectCrops[options->numberOfObjectCrops++] = argv[++i];
+        else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
+            options->spoolDirectory = argv[++i];
+        else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc)
+            options->objectSnapshot = argv[++i];
+        else if (strcmp(argv[i], "--save-objects") == 0 && i + 1 < argc)
+            options->saveObjectSnapshot = argv[++i];
+        else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+            options->cacheDirectory = argv[++i];
+        else if (strcmp(argv[i], "--cache-size") == 0 && i + 1 < argc)
+            options->cacheMegabytes = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--score-maps") == 0 && i + 1 < argc)
+            options->scoreMapDirectory = argv[++i];
+        else if (strcmp(argv[i], "--dispatch") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "input") == 0)
+                options->dispatchOrder = DISPATCH_INPUT_ORDER;
+            else if (strcmp(argv[i], "largest") == 0)
+                options->dispatchOrder = DISPATCH_LARGEST_FIRST;
+            else
+            {
+                printf("Unknown dispatch order %s \r \n", argv[i]);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        else if (strcmp(argv[i], "--split") == 0)
+            options->splitPictures = 1;
+        else if (strcmp(argv[i], "--orientations") == 0)
+            options->orientations = 1;
+        else if (strcmp(argv[i], "--transparent") == 0 && i + 1 < argc)
+        {
+            options->maskObjects = 1;
+            options->transparentColor = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--batch") == 0)
+            options->batchPictures = 1;
+        else if (strcmp(argv[i], "--numa") == 0)
+            options->numa = 1;
+        else if (strcmp(argv[i], "--thresholds") == 0 && i + 1 < argc)
+        {
+            char *list = argv[++i], *end;
+            options->numberOfThresholds = 0;
+            while (options->numberOfThresholds < MAX_THRESHOLDS)
+            {
+                options->thresholds[options->numberOfThresholds++] = strtod(list, &end);
+                if (end == list || (*end != ',' && *end != '\0'))
+                {
+                    printf("Invalid threshold list %s \r \n", argv[i]);
+                    MPI_Abort(MPI_COMM_WORLD, 1);
+                }
+                if (*end == '\0')
+                    break;
+                list = end + 1;
+            }
+        }
+        else if (strcmp(argv[i], "--result-format") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "text") == 0)
+                options->resultFormat = RESULT_FORMAT_TEXT;
+            else if (strcmp(argv[i], "binary") == 0)
+                options->resultFormat = RESULT_FORMAT_BINARY;
+            else if (strcmp(argv[i], "jsonl") == 0)
+                options->resultFormat = RESULT_FORMAT_JSONL;
+            else
+            {
+                printf("Unknown result format %s \r \n", argv[i]);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+        }
+        else
+        {
+            printf("Unknown option %s \r \n", argv[i]);
+            printf("Usage: %s [--input file] [--parallel-output] [--result-format text|binary|jsonl] [--trace] [--backend name] [--threads n] [--threshold t] [--serve directory] \r \n", argv[0]);
+            printf("       [--objects snapshot] [--save-objects snapshot] [--cache directory] [--cache-size megabytes] [--score-maps directory] \r \n");
+            printf("       [--thresholds t1,t2,...] [--numa] [--dispatch input|largest] [--batch] [--split] [--orientations] [--transparent color] \r \n");
+            printf("       [--images path]... [--object-images path]... [--crop-object picture,row,column,width[,height]]... \r \n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    // a service has no single output file, the master writes the result of every job
+    if (options->spoolDirectory != NULL)
+        options->parallelOutput = 0;
+
+    // a single threshold in the list is a plain search, several are written by the master to one file per threshold
+    if (options->numberOfThresholds == 1)
+    {
+        options->matchingThreshold = options->thresholds[0];
+        options->numberOfThresholds = 0;
+    }
+    if (options->numberOfThresholds > 1)
+    {
+        if (options->spoolDirectory != NULL)
+        {
+            printf("--thresholds is not supported in service mode \r \n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        options->parallelOutput = 0;
+    }
+
+    // the cache and score maps hold the first match of the objects as they are, and a strip halo is as high as the objects
+    if (options->orientations)
+    {
+        if (options->numberOfThresholds > 1)
+        {
+            printf("--orientations is not supported with --thresholds \r \n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        options->cacheDirectory = NULL;
+        options->scoreMapDirectory = NULL;
+        options->splitPictures = 0;
+    }
+
+    // the same holds for masked objects, but their strips keep the height of the objects
+    if (options->maskObjects)
+    {
+        if (options->numberOfThresholds > 1 || options->orientations)
+        {
+            printf("--transparent is not supported with --thresholds or --orientations \r \n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        options->cacheDirectory = NULL;
+        options->scoreMapDirectory = NULL;
+    }
+}
+
+const char *outputFileName(int resultFormat)
+{
+    if (resultFormat == RESULT_FORMAT_BINARY)
+        return BINARY_OUTPUT_FILE;
+    if (resultFormat == RESULT_FORMAT_JSONL)
+        return JSONL_OUTPUT_FILE;
+    return OUTPUT_FILE;
+}
+
+void thresholdOutputFileName(int resultFormat, double matchingThreshold, char *file)
+{
+    const char *outputFile = outputFileName(resultFormat);
+    const char *extension = strrchr(outputFile, '.');
+    snprintf(file, MAX_THRESHOLD_FILE_NAME, "%.*s_%g%s", (int)(extension - outputFile), outputFile, matchingThreshold, extension);
 }
 
-void writeLogs(const char *outputFile, Logs **logs, int numberOfLogs)
+int maxLogRecordLength(Logs *log, int resultFormat)
+{
+    if (resultFormat == RESULT_FORMAT_BINARY)
+        return sizeof(ResultPictureRecord) + log->numObjectsFound * sizeof(ResultObjectRecord);
+    if (resultFormat == RESULT_FORMAT_JSONL)
+        return MAX_JSONL_LINE_HEADER + log->numObjectsFound * MAX_JSONL_LINE_ENTRY;
+    return MAX_LOG_LINE_HEADER + log->numObjectsFound * MAX_LOG_LINE_ENTRY;
+}
+
+/*
+ * This function formats the header of the output file, the binary format starts with its magic and version
+ * @return: the length of the header, 0 for the text formats
+ */
+static int formatFileHeader(int resultFormat, ResultFileHeader *header)
+{
+    if (resultFormat != RESULT_FORMAT_BINARY)
+        return 0;
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, RESULT_FILE_MAGIC, sizeof(header->magic));
+    header->version = RESULT_FILE_VERSION;
+    return sizeof(*header);
+}
+
+static int formatBinaryLog(Logs *log, char *record)
+{
+    int length = 0;
+
+    ResultPictureRecord pictureRecord;
+    pictureRecord.pictureID = log->pictureID;
+    pictureRecord.numObjectsFound = log->numObjectsFound;
+    pictureRecord.searchTime = log->searchTime;
+    memcpy(record + length, &pictureRecord, sizeof(pictureRecord));
+    length += sizeof(pictureRecord);
+
+    for (int j = 0; j < log->numObjectsFound; j++)
+    {
+        ResultObjectRecord objectRecord;
+        objectRecord.objectID = log->objectIDs[j];
+        objectRecord.row = log->objectPositions[j].row;
+        objectRecord.column = log->objectPositions[j].column;
+        objectRecord.orientation = log->objectOrientations[j];
+        objectRecord.score = log->objectScores[j];
+        objectRecord.computeTime = log->objectTimes[j];
+        memcpy(record + length, &objectRecord, sizeof(objectRecord));
+        length += sizeof(objectRecord);
+    }
+    return length;
+}
+
+static int formatJsonlLog(Logs *log, char *record)
+{
+    int length = 0;
+
+    length += sprintf(record + length, "{\"picture\":%d,\"searchTime\":%.9g,\"objects\":[", log->pictureID, log->searchTime);
+    for (int j = 0; j < log->numObjectsFound; j++)
+        length += sprintf(record + length, "%s{\"object\":%d,\"row\":%d,\"column\":%d,\"orientation\":%d,\"score\":%.17g,\"time\":%.9g}", j > 0 ? "," : "",
+                          log->objectIDs[j], log->objectPositions[j].row, log->objectPositions[j].column, log->objectOrientations[j],
+                          log->objectScores[j], log->objectTimes[j]);
+    length += sprintf(record + length, "]}\n");
+    return length;
+}
+
+int formatLog(Logs *log, int resultFormat, char *record)
+{
+    int length = 0;
+
+    if (resultFormat == RESULT_FORMAT_BINARY)
+        return formatBinaryLog(log, record);
+    if (resultFormat == RESULT_FORMAT_JSONL)
+        return formatJsonlLog(log, record);
+
+    if (log->numObjectsFound < 3)
+        return sprintf(record, "Picture %d: No three different Objects were found\r\n", log->pictureID);
+
+    length += sprintf(record + length, "Picture %d: found Objects: ", log->pictureID);
+    for (int j = 0; j < log->numObjectsFound; j++)
+        if (log->objectPositions[j].row != -1 && log->objectPositions[j].column != -1)
+        {
+            length += sprintf(record + length, " %d Position(%d,%d)", log->objectIDs[j], log->objectPositions[j].row, log->objectPositions[j].column);
+            // objects found as they are keep the original line format
+            if (log->objectOrientations[j] != 0)
+                length += sprintf(record + length, " Orientation(%d)", log->objectOrientations[j]);
+            length += sprintf(record + length, ";");
+        }
+    length += sprintf(record + length, "\r\n");
+    return length;
+}
+
+void writeLogs(const char *outputFile, Logs **logs, int numberOfLogs, int resultFormat)
 {
     // Open file
-    FILE *fp = fopen(outputFile, "w");
+    FILE *fp = fopen(outputFile, "wb");
     checkMalloc(fp, "file pointer");
 
+    // the file header does not depend on the logs, so a file without pictures still has it
+    ResultFileHeader header;
+    fwrite(&header, 1, formatFileHeader(resultFormat, &header), fp);
+
     // write logs to file
     for (int i = 0; i < numberOfLogs; i++)
     {
-        if ((*logs)[i].numObjectsFound < 3)
-            fprintf(fp, "Picture %d: No three different Objects were found\r\n", (*logs)[i].pictureID);
-        else
-        {
-            fprintf(fp, "Picture %d: found Objects: ", (*logs)[i].pictureID);
-            for (int j = 0; j < (*logs)[i].numObjectsFound; j++)
-                if ((*logs)[i].objectPositions[j].row != -1 && (*logs)[i].objectPositions[j].column != -1)
-                    fprintf(fp, " %d Position(%d,%d);", (*logs)[i].objectIDs[j], (*logs)[i].objectPositions[j].row, (*logs)[i].objectPositions[j].column);
-            fprintf(fp, "\r\n");
-        }
+        char *record = (char *)malloc(maxLogRecordLength(&(*logs)[i], resultFormat) + 1);
+        checkMalloc(record, "log record");
+        fwrite(record, 1, formatLog(&(*logs)[i], resultFormat, record), fp);
+        free(record);
     }
     fclose(fp);
 }
 
+struct IndexedRecordStruct
+{
+    int index;
+    int length;
+    char *record;
+};
+typedef struct IndexedRecordStruct IndexedRecord;
+
+static int compareIndexedRecords(const void *a, const void *b)
+{
+    return ((const IndexedRecord *)a)->index - ((const IndexedRecord *)b)->index;
+}
+
+void writeLogsParallel(const char *outputFile, char **records, int *recordLengths, int *recordIndices, int numberOfRecords, int numberOfPictures, int resultFormat)
+{
+    MPI_File fp;
+    MPI_Datatype fileType;
+    MPI_Status status;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    // rank 0 writes the file header at offset 0, the records follow it
+    ResultFileHeader header;
+    int headerLength = formatFileHeader(resultFormat, &header);
+
+    // every record is formatted by exactly one process, so summing the lengths gathers all of them
+    int *pictureLengths = (int *)calloc(numberOfPictures + 1, sizeof(int));
+    checkMalloc(pictureLengths, "record lengths array");
+    for (int i = 0; i < numberOfRecords; i++)
+        pictureLengths[recordIndices[i]] = recordLengths[i];
+    MPI_Allreduce(MPI_IN_PLACE, pictureLengths, numberOfPictures, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    // exclusive prefix sum of the lengths gives the offset of each record in the file
+    MPI_Aint *pictureOffsets = (MPI_Aint *)malloc((numberOfPictures + 1) * sizeof(MPI_Aint));
+    checkMalloc(pictureOffsets, "record offsets array");
+    MPI_Aint offset = headerLength;
+    for (int i = 0; i < numberOfPictures; i++)
+    {
+        pictureOffsets[i] = offset;
+        offset += pictureLengths[i];
+    }
+
+    // the file view must be monotonic, so the local records are packed in picture order
+    IndexedRecord *sortedRecords = (IndexedRecord *)malloc((numberOfRecords + 1) * sizeof(IndexedRecord));
+    checkMalloc(sortedRecords, "sorted records array");
+    for (int i = 0; i < numberOfRecords; i++)
+    {
+        sortedRecords[i].index = recordIndices[i];
+        sortedRecords[i].length = recordLengths[i];
+        sortedRecords[i].record = records[i];
+    }
+    qsort(sortedRecords, numberOfRecords, sizeof(IndexedRecord), compareIndexedRecords);
+
+    int *blockLengths = (int *)malloc((numberOfRecords + 2) * sizeof(int));
+    checkMalloc(blockLengths, "block lengths array");
+    MPI_Aint *blockOffsets = (MPI_Aint *)malloc((numberOfRecords + 2) * sizeof(MPI_Aint));
+    checkMalloc(blockOffsets, "block offsets array");
+    int numberOfBlocks = 0, bufferLength = 0;
+    if (rank == 0 && headerLength > 0)
+    {
+        blockLengths[numberOfBlocks] = headerLength;
+        blockOffsets[numberOfBlocks++] = 0;
+        bufferLength += headerLength;
+    }
+    for (int i = 0; i < numberOfRecords; i++)
+    {
+        blockLengths[numberOfBlocks] = sortedRecords[i].length;
+        blockOffsets[numberOfBlocks++] = pictureOffsets[sortedRecords[i].index];
+        bufferLength += sortedRecords[i].length;
+    }
+    char *buffer = (char *)malloc(bufferLength + 1);
+    checkMalloc(buffer, "output buffer");
+    int position = 0;
+    if (rank == 0)
+    {
+        memcpy(buffer, &header, headerLength);
+        position += headerLength;
+    }
+    for (int i = 0; i < numberOfRecords; i++)
+    {
+        memcpy(buffer + position, sortedRecords[i].record, sortedRecords[i].length);
+        position += sortedRecords[i].length;
+    }
+
+    MPI_Type_create_hindexed(numberOfBlocks, blockLengths, blockOffsets, MPI_CHAR, &fileType);
+    MPI_Type_commit(&fileType);
+
+    if (MPI_File_open(MPI_COMM_WORLD, outputFile, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fp) != MPI_SUCCESS)
+        checkMalloc(NULL, "file pointer");
+    MPI_File_set_size(fp, 0);
+    MPI_File_set_view(fp, 0, MPI_CHAR, fileType, "native", MPI_INFO_NULL);
+    MPI_File_write_at_all(fp, 0, buffer, bufferLength, MPI_CHAR, &status);
+    MPI_File_close(&fp);
+
+    MPI_Type_free(&fileType);
+    free(buffer);
+    free(blockOffsets);
+    free(blockLengths);
+    free(sortedRecords);
+    free(pictureOffsets);
+    free(pictureLengths);
+}
+
+/*
+ * This function creates the datatype of the colors of a matrix without its row padding
+ * @return: the committed datatype, released with MPI_Type_free
+ */
+static MPI_Datatype colorsMatrixType(int width, int height, int pitch)
+{
+    MPI_Datatype colorsType;
+    MPI_Type_vector(height, width, pitch, MPI_INT, &colorsType);
+    MPI_Type_commit(&colorsType);
+    return colorsType;
+}
+
+/*
+ * This function sends the size and the colors of a picture or object, the padding of the rows is not sent
+ * @return: void
+ */
+static void sendColorsMatrix(int *colorsMatrix, int width, int height, int pitch, int destRank, int tag)
+{
+    int size[2] = {width, height};
+    MPI_Send(size, 2, MPI_INT, destRank, tag, MPI_COMM_WORLD);
+    MPI_Datatype colorsType = colorsMatrixType(width, height, pitch);
+    MPI_Send(colorsMatrix, 1, colorsType, destRank, tag, MPI_COMM_WORLD);
+    MPI_Type_free(&colorsType);
+}
+
+/*
+ * This function receives the size and the colors of a picture or object into a newly allocated matrix
+ * @return: void
+ */
+static void receiveColorsMatrix(int **colorsMatrix, int *width, int *height, int *pitch, int sourceRank, int tag, MPI_Status *status, Arena *arena)
+{
+    int size[2];
+    MPI_Recv(size, 2, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
+    *width = size[0];
+    *height = size[1];
+    if (arena != NULL)
+    {
+        // the padding colors are not received, they are zeroed like in allocateColorsMatrix
+        *pitch = rowPitch(*width);
+        *colorsMatrix = (int *)arenaAllocate(arena, (size_t)*pitch * *height * sizeof(int));
+        for (int i = 0; i < *height; i++)
+            memset(*colorsMatrix + (size_t)i * *pitch + *width, 0, (*pitch - *width) * sizeof(int));
+    }
+    else
+        *colorsMatrix = allocateColorsMatrix(*width, *height, pitch);
+    checkMalloc(*colorsMatrix, "colors matrix");
+    MPI_Datatype colorsType = colorsMatrixType(*width, *height, *pitch);
+    MPI_Recv(*colorsMatrix, 1, colorsType, sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Type_free(&colorsType);
+}
+
 void sendPicture(Picture *picture, int destRank, int tag)
 {
     MPI_Send(&picture->ID, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
-    MPI_Send(&picture->dimension, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
-    MPI_Send(picture->colorsMatrix, picture->dimension * picture->dimension, MPI_INT, destRank, tag, MPI_COMM_WORLD);
+    sendColorsMatrix(picture->colorsMatrix, picture->width, picture->height, picture->pitch, destRank, tag);
 }
 
-void receivePicture(Picture *picture, int sourceRank, int tag, MPI_Status *status)
+void receivePicture(Picture *picture, int sourceRank, int tag, MPI_Status *status, Arena *arena)
 {
     MPI_Recv(&picture->ID, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
-    MPI_Recv(&picture->dimension, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
-    picture->colorsMatrix = (int *)malloc(picture->dimension * picture->dimension * sizeof(int));
-    checkMalloc(picture->colorsMatrix, "colors matrix of picture");
-    MPI_Recv(picture->colorsMatrix, picture->dimension * picture->dimension, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
+    receiveColorsMatrix(&picture->colorsMatrix, &picture->width, &picture->height, &picture->pitch, sourceRank, tag, status, arena);
 }
 
 void sendLog(Logs *log, int destRank, int tag)
@@ -164,66 +835,319 @@ void sendLog(Logs *log, int destRank, int tag)
         MPI_Send(&log->objectPositions[i].row, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
         MPI_Send(&log->objectPositions[i].column, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
     }
+    MPI_Send(log->objectScores, log->numObjectsFound, MPI_DOUBLE, destRank, tag, MPI_COMM_WORLD);
+    MPI_Send(log->objectTimes, log->numObjectsFound, MPI_DOUBLE, destRank, tag, MPI_COMM_WORLD);
+    MPI_Send(log->objectOrientations, log->numObjectsFound, MPI_INT, destRank, tag, MPI_COMM_WORLD);
+    MPI_Send(&log->searchTime, 1, MPI_DOUBLE, destRank, tag, MPI_COMM_WORLD);
 }
 
-void receiveLog(Logs *log, int sourceRank, int tag, MPI_Status *status)
+void receiveLog(Logs *log, int sourceRank, int tag, MPI_Status *status, Arena *arena)
 {
     MPI_Recv(&log->pictureID, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
+    // the rest of the log must come from the same process, even when receiving from any source
+    sourceRank = status->MPI_SOURCE;
     MPI_Recv(&log->numObjectsFound, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
-    log->objectIDs = (int *)malloc(log->numObjectsFound * sizeof(int));
-    checkMalloc(log->objectIDs, "object IDs of picture");
-    log->objectPositions = (Position *)malloc(log->numObjectsFound * sizeof(Position));
-    checkMalloc(log->objectPositions, "object positions of picture");
+    allocateLogArrays(log, log->numObjectsFound, arena);
     MPI_Recv(log->objectIDs, log->numObjectsFound, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
     for (int i = 0; i < log->numObjectsFound; i++)
     {
         MPI_Recv(&log->objectPositions[i].row, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
         MPI_Recv(&log->objectPositions[i].column, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
     }
+    MPI_Recv(log->objectScores, log->numObjectsFound, MPI_DOUBLE, sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Recv(log->objectTimes, log->numObjectsFound, MPI_DOUBLE, sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Recv(log->objectOrientations, log->numObjectsFound, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Recv(&log->searchTime, 1, MPI_DOUBLE, sourceRank, tag, MPI_COMM_WORLD, status);
+}
+
+/*
+ * This function adds the packed size of count members of a type to a packed message size
+ */
+static void addPackSize(int count, MPI_Datatype type, int *packSize)
+{
+    int typeSize;
+    MPI_Pack_size(count, type, MPI_COMM_WORLD, &typeSize);
+    *packSize += typeSize;
+}
+
+void sendPictureBatch(Picture *pictures, int *indices, int numberOfPictures, int destRank, int tag)
+{
+    int packSize = 0, position = 0;
+    addPackSize(1, MPI_INT, &packSize);
+    for (int p = 0; p < numberOfPictures; p++)
+    {
+        Picture *picture = &pictures[indices[p]];
+        addPackSize(4, MPI_INT, &packSize);
+        for (int i = 0; i < picture->height; i++)
+            addPackSize(picture->width, MPI_INT, &packSize);
+    }
+
+    char *buffer = (char *)malloc(packSize);
+    checkMalloc(buffer, "picture batch buffer");
+    MPI_Pack(&numberOfPictures, 1, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+    for (int p = 0; p < numberOfPictures; p++)
+    {
+        Picture *picture = &pictures[indices[p]];
+        int header[4] = {indices[p], picture->ID, picture->width, picture->height};
+        MPI_Pack(header, 4, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+        // only the colors are packed, not the padding of the rows
+        for (int i = 0; i < picture->height; i++)
+            MPI_Pack(picture->colorsMatrix + (size_t)i * picture->pitch, picture->width, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+    }
+    MPI_Send(buffer, position, MPI_PACKED, destRank, tag, MPI_COMM_WORLD);
+    free(buffer);
+}
+
+int receivePictureBatch(Picture **pictures, int **indices, int sourceRank, int tag, MPI_Status *status, Arena *arena)
+{
+    int packSize, position = 0, numberOfPictures;
+    MPI_Probe(sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Get_count(status, MPI_PACKED, &packSize);
+    char *buffer = (char *)arenaAllocate(arena, packSize);
+    MPI_Recv(buffer, packSize, MPI_PACKED, status->MPI_SOURCE, tag, MPI_COMM_WORLD, status);
+
+    MPI_Unpack(buffer, packSize, &position, &numberOfPictures, 1, MPI_INT, MPI_COMM_WORLD);
+    *pictures = (Picture *)arenaAllocate(arena, numberOfPictures * sizeof(Picture));
+    *indices = (int *)arenaAllocate(arena, numberOfPictures * sizeof(int));
+    for (int p = 0; p < numberOfPictures; p++)
+    {
+        Picture *picture = &(*pictures)[p];
+        int header[4];
+        MPI_Unpack(buffer, packSize, &position, header, 4, MPI_INT, MPI_COMM_WORLD);
+        (*indices)[p] = header[0];
+        picture->ID = header[1];
+        picture->width = header[2];
+        picture->height = header[3];
+        picture->pitch = rowPitch(picture->width);
+        picture->colorsMatrix = (int *)arenaAllocate(arena, (size_t)picture->pitch * picture->height * sizeof(int));
+        for (int i = 0; i < picture->height; i++)
+        {
+            int *row = picture->colorsMatrix + (size_t)i * picture->pitch;
+            MPI_Unpack(buffer, packSize, &position, row, picture->width, MPI_INT, MPI_COMM_WORLD);
+            memset(row + picture->width, 0, (picture->pitch - picture->width) * sizeof(int));
+        }
+    }
+    return numberOfPictures;
+}
+
+void sendLogBatch(Logs *logs, int numberOfLogs, int destRank, int tag)
+{
+    int packSize = 0, position = 0;
+    for (int l = 0; l < numberOfLogs; l++)
+    {
+        addPackSize(2, MPI_INT, &packSize);
+        addPackSize(4 * logs[l].numObjectsFound, MPI_INT, &packSize);
+        addPackSize(2 * logs[l].numObjectsFound + 1, MPI_DOUBLE, &packSize);
+    }
+
+    char *buffer = (char *)malloc(packSize + 1);
+    checkMalloc(buffer, "log batch buffer");
+    for (int l = 0; l < numberOfLogs; l++)
+    {
+        Logs *log = &logs[l];
+        int header[2] = {log->pictureID, log->numObjectsFound};
+        MPI_Pack(header, 2, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(log->objectIDs, log->numObjectsFound, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(log->objectPositions, 2 * log->numObjectsFound, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(log->objectScores, log->numObjectsFound, MPI_DOUBLE, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(log->objectTimes, log->numObjectsFound, MPI_DOUBLE, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(log->objectOrientations, log->numObjectsFound, MPI_INT, buffer, packSize, &position, MPI_COMM_WORLD);
+        MPI_Pack(&log->searchTime, 1, MPI_DOUBLE, buffer, packSize, &position, MPI_COMM_WORLD);
+    }
+    MPI_Send(buffer, position, MPI_PACKED, destRank, tag, MPI_COMM_WORLD);
+    free(buffer);
+}
+
+void receiveLogBatch(Logs *logs, int numberOfLogs, int sourceRank, int tag, MPI_Status *status, Arena *arena)
+{
+    int packSize, position = 0;
+    MPI_Probe(sourceRank, tag, MPI_COMM_WORLD, status);
+    MPI_Get_count(status, MPI_PACKED, &packSize);
+    char *buffer = (char *)malloc(packSize + 1);
+    checkMalloc(buffer, "log batch buffer");
+    MPI_Recv(buffer, packSize, MPI_PACKED, status->MPI_SOURCE, tag, MPI_COMM_WORLD, status);
+
+    for (int l = 0; l < numberOfLogs; l++)
+    {
+        Logs *log = &logs[l];
+        int header[2];
+        MPI_Unpack(buffer, packSize, &position, header, 2, MPI_INT, MPI_COMM_WORLD);
+        log->pictureID = header[0];
+        log->numObjectsFound = header[1];
+        allocateLogArrays(log, log->numObjectsFound, arena);
+        MPI_Unpack(buffer, packSize, &position, log->objectIDs, log->numObjectsFound, MPI_INT, MPI_COMM_WORLD);
+        MPI_Unpack(buffer, packSize, &position, log->objectPositions, 2 * log->numObjectsFound, MPI_INT, MPI_COMM_WORLD);
+        MPI_Unpack(buffer, packSize, &position, log->objectScores, log->numObjectsFound, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack(buffer, packSize, &position, log->objectTimes, log->numObjectsFound, MPI_DOUBLE, MPI_COMM_WORLD);
+        MPI_Unpack(buffer, packSize, &position, log->objectOrientations, log->numObjectsFound, MPI_INT, MPI_COMM_WORLD);
+        MPI_Unpack(buffer, packSize, &position, &log->searchTime, 1, MPI_DOUBLE, MPI_COMM_WORLD);
+    }
+    free(buffer);
 }
 
 void sendObject(Object *object, int destRank, int tag)
 {
     MPI_Send(&object->ID, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
-    MPI_Send(&object->dimension, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
-    MPI_Send(object->subColorsMatrix, object->dimension * object->dimension, MPI_INT, destRank, tag, MPI_COMM_WORLD);
+    sendColorsMatrix(object->subColorsMatrix, object->width, object->height, object->pitch, destRank, tag);
 }
 
 void receiveObject(Object *object, int sourceRank, int tag, MPI_Status *status)
 {
     MPI_Recv(&object->ID, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
-    MPI_Recv(&object->dimension, 1, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
-    object->subColorsMatrix = (int *)malloc(object->dimension * object->dimension * sizeof(int));
-    checkMalloc(object->subColorsMatrix, "colors matrix of object");
-    MPI_Recv(object->subColorsMatrix, object->dimension * object->dimension, MPI_INT, sourceRank, tag, MPI_COMM_WORLD, status);
+    object->colorCounts = NULL;
+    object->visitBlocks = NULL;
+    receiveColorsMatrix(&object->subColorsMatrix, &object->width, &object->height, &object->pitch, sourceRank, tag, status, NULL);
+}
+
+double calculateMatchingScore(Picture *picture, Object *object, int row, int column)
+{
+    double res = 0;
+
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int objectColor = object->subColorsMatrix[i * object->pitch + j];
+            int pictureColor = picture->colorsMatrix[(row + i) * picture->pitch + (column + j)];
+            if (pictureColor != 0)
+                res += (double)abs(pictureColor - objectColor) / pictureColor;
+        }
+    return res / (object->width * object->height);
+}
+
+void pictureStrip(Picture *picture, Object *object, int firstRow, int numberOfRows, Picture *strip)
+{
+    strip->ID = picture->ID;
+    strip->width = picture->width;
+    strip->height = numberOfRows + object->height - 1;
+    strip->pitch = picture->pitch;
+    strip->colorsMatrix = picture->colorsMatrix + (size_t)firstRow * picture->pitch;
 }
 
-void findObjectsInPicture(Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold)
+void findObjectsInPicture(Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold, MatchingFunction matchingFunction, int numThreads, int numberOfStrips)
 {
-    #pragma omp parallel num_threads(numberOfObjects)
+    double searchStartTime = omp_get_wtime();
+
+    // the first match of every strip of every object, and the compute time of every object over its strips
+    int *stripCorners = (int *)malloc((size_t)numberOfObjects * numberOfStrips * sizeof(int));
+    checkMalloc(stripCorners, "strip corners array");
+    double *objectTimes = (double *)calloc(numberOfObjects, sizeof(double));
+    checkMalloc(objectTimes, "object times array");
+
+    #pragma omp parallel num_threads(numThreads > 0 ? numThreads : numberOfObjects)
     {
         #pragma omp single
         {
             for (int i = 0; i < numberOfObjects; i++)
             {
-                #pragma omp task firstprivate(i)
+                int positionRows = picture->height - objects[i].height + 1;
+                for (int s = 0; s < numberOfStrips; s++)
                 {
-                    int upperLeftCorner = NOT_FOUND;
-                    // calculate the matching value for each possible position of the object in the picture using CUDA
-                    calculateMatchingOnGPU(picture, objects + i, &upperLeftCorner, matchingThreshold);
-                    if (upperLeftCorner != NOT_FOUND)
+                    int firstRow = positionRows > 0 ? (long long)s * positionRows / numberOfStrips : 0;
+                    int numberOfRows = positionRows > 0 ? (long long)(s + 1) * positionRows / numberOfStrips - firstRow : 0;
+                    stripCorners[i * numberOfStrips + s] = NOT_FOUND;
+                    if (numberOfRows == 0)
+                        continue;
+
+                    #pragma omp task firstprivate(i, s, firstRow, numberOfRows)
                     {
-                        #pragma omp critical
-                        {
-                            log->pictureID = picture->ID;
-                            log->objectIDs[log->numObjectsFound] = objects[i].ID;
-                            log->objectPositions[log->numObjectsFound].row = upperLeftCorner / picture->dimension;
-                            log->objectPositions[log->numObjectsFound].column = upperLeftCorner % picture->dimension;
-                            log->numObjectsFound++;
-                        }
+                        int upperLeftCorner = NOT_FOUND;
+                        double objectStartTime = omp_get_wtime();
+                        double traceStartTime = traceNow();
+                        // calculate the matching value for each possible position of the strip using the backend
+                        Picture strip;
+                        pictureStrip(picture, objects + i, firstRow, numberOfRows, &strip);
+                        matchingFunction(&strip, objects + i, &upperLeftCorner, matchingThreshold);
+                        traceRecord("search object", traceStartTime, traceNow(), objects[i].ID);
+                        if (upperLeftCorner != NOT_FOUND)
+                            stripCorners[i * numberOfStrips + s] = upperLeftCorner + firstRow * picture->width;
+                        double stripTime = omp_get_wtime() - objectStartTime;
+                        #pragma omp atomic
+                        objectTimes[i] += stripTime;
                     }
                 }
             }
         }
     }
+
+    // the strips are in row order, so the first strip with a match holds the first match of the object
+    log->pictureID = picture->ID;
+    for (int i = 0; i < numberOfObjects; i++)
+        for (int s = 0; s < numberOfStrips; s++)
+        {
+            int upperLeftCorner = stripCorners[i * numberOfStrips + s];
+            if (upperLeftCorner == NOT_FOUND)
+                continue;
+            int row = upperLeftCorner / picture->width;
+            int column = upperLeftCorner % picture->width;
+            // the kernel only reports the position, the score of that position is recomputed here
+            log->objectIDs[log->numObjectsFound] = objects[i].ID;
+            log->objectPositions[log->numObjectsFound].row = row;
+            log->objectPositions[log->numObjectsFound].column = column;
+            log->objectScores[log->numObjectsFound] = calculateMatchingScore(picture, objects + i, row, column);
+            log->objectTimes[log->numObjectsFound] = objectTimes[i];
+            log->objectOrientations[log->numObjectsFound] = 0;
+            log->numObjectsFound++;
+            break;
+        }
+    free(stripCorners);
+    free(objectTimes);
+
+    log->searchTime = omp_get_wtime() - searchStartTime;
+}
+
+void findObjectsAtThresholds(Picture *picture, Object *objects, Logs *logs, int numberOfObjects, const double *matchingThresholds, int numberOfThresholds, int numThreads)
+{
+    double searchStartTime = omp_get_wtime();
+    // the corners of object i are upperLeftCorners[i * numberOfThresholds + k]
+    int *upperLeftCorners = (int *)malloc(((size_t)numberOfObjects * numberOfThresholds + 1) * sizeof(int));
+    checkMalloc(upperLeftCorners, "upper left corners array");
+    double *objectTimes = (double *)malloc((numberOfObjects + 1) * sizeof(double));
+    checkMalloc(objectTimes, "object times array");
+
+    #pragma omp parallel num_threads(numThreads > 0 ? numThreads : numberOfObjects)
+    {
+        #pragma omp single
+        {
+            for (int i = 0; i < numberOfObjects; i++)
+            {
+                #pragma omp task firstprivate(i)
+                {
+                    double objectStartTime = omp_get_wtime();
+                    double traceStartTime = traceNow();
+                    calculateMatchingThresholds(picture, objects + i, upperLeftCorners + (size_t)i * numberOfThresholds, matchingThresholds, numberOfThresholds);
+                    traceRecord("search object", traceStartTime, traceNow(), objects[i].ID);
+                    objectTimes[i] = omp_get_wtime() - objectStartTime;
+                }
+            }
+        }
+    }
+
+    // the logs are built after the search, so the found objects are in object order like findObjectsInPicture
+    for (int k = 0; k < numberOfThresholds; k++)
+    {
+        Logs *log = &logs[k];
+        for (int i = 0; i < numberOfObjects; i++)
+        {
+            int upperLeftCorner = upperLeftCorners[(size_t)i * numberOfThresholds + k];
+            if (upperLeftCorner == NOT_FOUND)
+                continue;
+            int row = upperLeftCorner / picture->width;
+            int column = upperLeftCorner % picture->width;
+            log->objectIDs[log->numObjectsFound] = objects[i].ID;
+            log->objectPositions[log->numObjectsFound].row = row;
+            log->objectPositions[log->numObjectsFound].column = column;
+            log->objectScores[log->numObjectsFound] = calculateMatchingScore(picture, objects + i, row, column);
+            log->objectTimes[log->numObjectsFound] = objectTimes[i];
+            log->objectOrientations[log->numObjectsFound] = 0;
+            log->numObjectsFound++;
+        }
+    }
+    free(upperLeftCorners);
+    free(objectTimes);
+
+    for (int k = 0; k < numberOfThresholds; k++)
+    {
+        logs[k].pictureID = picture->ID;
+        logs[k].searchTime = omp_get_wtime() - searchStartTime;
+    }
 }
@@ -3,17 +3,53 @@
 
 #define INPUT_FILE "input.txt"
 #define OUTPUT_FILE "output.txt"
+#define BINARY_OUTPUT_FILE "output.bin"
+#define JSONL_OUTPUT_FILE "output.jsonl"
 #define PICTURE_TAG 0
 #define OBJECT_TAG 1
 #define LOGS_TAG 2
 #define TERMINATE_TAG 3
+#define LAST_PICTURE_TAG 4 // a picture of the final phase, nothing may follow it
+#define BATCH_TAG 5
 #define THREADS_PER_BLOCK 1024
 #define NOT_FOUND -1
+#define ROW_ALIGNMENT 16 // ints, rows start on 64 byte boundaries
+#define HISTOGRAM_COLORS 101 // colors 0 to 100
+#define MIN_COLOR 1 // the colors of generated and converted images
+#define MAX_COLOR 100
+#define DEFAULT_BACKEND "gpu"
+#define DEFAULT_CACHE_MEGABYTES 256
+#define MAX_OPTION_PATHS 64
+#define MAX_THRESHOLDS 16
+#define MAX_THRESHOLD_FILE_NAME 64
+#define DISPATCH_INPUT_ORDER 0
+#define DISPATCH_LARGEST_FIRST 1
+#define BATCH_COST 2e8 // estimated color comparisons of a batch of pictures
+#define BATCHES_PER_WORKER 4
+#define MAX_BATCH_PICTURES 256
+#define MAX_LOG_LINE_HEADER 64
+#define MAX_LOG_LINE_ENTRY 64
+#define MAX_JSONL_LINE_HEADER 96
+#define MAX_JSONL_LINE_ENTRY 160
+#define RESULT_FORMAT_TEXT 0
+#define RESULT_FORMAT_BINARY 1
+#define RESULT_FORMAT_JSONL 2
+#define RESULT_FILE_MAGIC "SIRB"
+#define RESULT_FILE_VERSION 1
+#define INPUT_FILE_MAGIC "SIRI"
+#define INPUT_FILE_VERSION 2
+#define SQUARE_INPUT_FILE_VERSION 1
 
+/*
+ * Colors are stored row by row, the first color of row i is at colorsMatrix[i * pitch].
+ * The pitch is the width rounded up to ROW_ALIGNMENT, so every row starts aligned; padding colors are 0.
+ */
 struct PictureStruct
 {
     int ID;
-    int dimension;
+    int width;
+    int height;
+    int pitch;
     int *colorsMatrix;
 };
 typedef struct PictureStruct Picture;
@@ -21,8 +57,12 @@ typedef struct PictureStruct Picture;
 struct ObjectStruct
 {
     int ID;
-    int dimension;
+    int width;
+    int height;
+    int pitch;
     int *subColorsMatrix;
+    int *colorCounts; // cumulative color histogram, NULL until computeColorCounts
+    struct VisitBlockStruct *visitBlocks; // the blocks of the ordered backend, NULL until computeVisitBlocks
 };
 typedef struct ObjectStruct Object;
 
@@ -39,9 +79,100 @@ struct LogsStruct
     int numObjectsFound;
     int *objectIDs;
     Position *objectPositions;
+    double *objectScores;
+    double *objectTimes;
+    int *objectOrientations; // see orientObject, 0 unless searching orientations
+    double searchTime;
 };
 typedef struct LogsStruct Logs;
 
+typedef struct ArenaStruct Arena; // see arenaHelper.h
+
+/*
+ * Binary result file layout (native byte order): one ResultFileHeader, then for every picture
+ * in input order one ResultPictureRecord followed by numObjectsFound ResultObjectRecords.
+ */
+struct ResultFileHeaderStruct
+{
+    char magic[4];
+    int version;
+};
+typedef struct ResultFileHeaderStruct ResultFileHeader;
+
+struct ResultPictureRecordStruct
+{
+    int pictureID;
+    int numObjectsFound;
+    double searchTime;
+};
+typedef struct ResultPictureRecordStruct ResultPictureRecord;
+
+struct ResultObjectRecordStruct
+{
+    int objectID;
+    int row;
+    int column;
+    int orientation; // see orientObject, 0 unless searching orientations
+    double score;
+    double computeTime;
+};
+typedef struct ResultObjectRecordStruct ResultObjectRecord;
+
+/*
+ * Binary input file layout (native byte order), the fast alternative to the text input format:
+ * one InputFileHeader, then for every picture its ID, width, height and width * height colors row by row as ints,
+ * then the number of objects as an int and for every object its ID, width, height and colors the same way.
+ * Files of SQUARE_INPUT_FILE_VERSION have a single dimension instead of the width and height.
+ */
+struct InputFileHeaderStruct
+{
+    char magic[4];
+    int version;
+    double matchingThreshold;
+    int numberOfPictures;
+    int reserved;
+};
+typedef struct InputFileHeaderStruct InputFileHeader;
+
+struct OptionsStruct
+{
+    const char *inputFile;
+    int parallelOutput;
+    int resultFormat;
+    int trace;
+    const char *backend;
+    int numThreads;
+    double matchingThreshold; // negative when not given, the input file decides
+    int numberOfImagePaths;
+    const char *imagePaths[MAX_OPTION_PATHS];
+    int numberOfObjectImagePaths;
+    const char *objectImagePaths[MAX_OPTION_PATHS];
+    int numberOfObjectCrops;
+    const char *objectCrops[MAX_OPTION_PATHS];
+    const char *spoolDirectory; // NULL unless running as a service, see serviceHelper.h
+    const char *objectSnapshot; // objects are mapped from this snapshot instead of sent, see snapshotHelper.h
+    const char *saveObjectSnapshot; // the objects of the input are written to this snapshot
+    const char *cacheDirectory; // NULL without a result cache, see cacheHelper.h
+    long long cacheMegabytes;
+    const char *scoreMapDirectory; // NULL without score maps, see scoreMapHelper.h
+    int numberOfThresholds; // more than 1 when every picture is searched for several thresholds in one pass
+    double thresholds[MAX_THRESHOLDS];
+    int numa; // pin threads, use huge pages and report the placement, see numaHelper.h
+    int dispatchOrder; // DISPATCH_INPUT_ORDER or DISPATCH_LARGEST_FIRST
+    int batchPictures; // send small pictures in batches
+    int splitPictures; // search large pictures in row strips on several workers
+    int orientations; // search the 8 rotations and mirror images of every object, see orientationHelper.h
+    int maskObjects; // skip the object members of transparentColor, see maskHelper.h
+    int transparentColor;
+};
+typedef struct OptionsStruct Options;
+
+/*
+ * Every matching backend has the signature of calculateMatchingOnGPU and reports the first
+ * matching position in row-major order, the same as referenceFirstMatch in reference.h.
+ */
+typedef void (*MatchingFunction)(Picture *picture, Object *object, int *upperLeftCorner, double matchingThreshold);
+
 // -----------------------Service Functions---------------------------
 
 /*
@@ -68,6 +199,57 @@ void freeObjects(Object *objects, int numObjects);
  */
 void freeLogs(Logs *logs, int numLogs);
 
+/*
+ * This function returns the row pitch of a colors matrix, the width rounded up to ROW_ALIGNMENT
+ * @param width: the width of the matrix
+ * @return: the pitch
+ */
+int rowPitch(int width);
+
+/*
+ * This function allocates a zeroed colors matrix with aligned rows
+ * @param width: the width of the matrix
+ * @param height: the height of the matrix
+ * @param pitch: the row pitch of the matrix
+ * @return: the colors matrix, released with free
+ */
+int *allocateColorsMatrix(int width, int height, int *pitch);
+
+/*
+ * This function allocates the object arrays of a log
+ * @param log: the log
+ * @param capacity: the number of objects the arrays hold
+ * @param arena: the arena of the arrays, NULL to allocate them with malloc, released with freeLogs
+ * @return: void
+ */
+void allocateLogArrays(Logs *log, int capacity, Arena *arena);
+
+/*
+ * This function allocates the colors matrix of a picture of the given size
+ * @param picture: the picture
+ * @param width: the width of the picture
+ * @param height: the height of the picture
+ * @return: void
+ */
+void allocatePicture(Picture *picture, int width, int height);
+
+/*
+ * This function allocates the colors matrix of an object of the given size
+ * @param object: the object
+ * @param width: the width of the object
+ * @param height: the height of the object
+ * @return: void
+ */
+void allocateObject(Object *object, int width, int height);
+
+/*
+ * This function computes the cumulative color histogram of an object: colorCounts[c] is the number of
+ * members with a color of at most c. Objects with colors outside 0 to HISTOGRAM_COLORS - 1 keep NULL.
+ * @param object: the object
+ * @return: void
+ */
+void computeColorCounts(Object *object);
+
 /*
  * This function checks if the fscanf function succeeded
  * @param read: the number of read items
@@ -89,31 +271,60 @@ void checkMalloc(void *ptr, const char *message);
  * This function reads the colors matrix from the input file
  * @param fp: the input file pointer
  * @param colorsMatrix: the colors matrix
- * @param dimension: the dimension of the matrix
- * @return: void
+ * @param width: the width of the matrix
+ * @param height: the height of the matrix
+ * @param pitch: the row pitch of the matrix
+ * @return: NULL, or what could not be read
  */
-void readColorsMatrix(FILE *fp, int *colorsMatrix, int dimension);
+const char *readColorsMatrix(FILE *fp, int *colorsMatrix, int width, int height, int pitch);
 
 /*
  * This function reads the pictures from the input file
  * @param fp: the input file pointer
  * @param pictures: pointer to the array of pictures
- * @param numberOfPictures: the number of pictures
- * @return: void
+ * @param numberOfPictures: the number of pictures, on an error the number of pictures allocated so far
+ * @return: NULL, or what could not be read
  */
-void readPictures(FILE *fp, Picture **pictures, int *numberOfPictures);
+const char *readPictures(FILE *fp, Picture **pictures, int *numberOfPictures);
 
 /*
  * This function reads the objects from the input file
  * @param fp: the input file pointer
  * @param objects: pointer to the array of objects
- * @param numberOfObjects: the number of objects
- * @return: void
+ * @param numberOfObjects: the number of objects, on an error the number of objects allocated so far
+ * @return: NULL, or what could not be read
+ */
+const char *readObjects(FILE *fp, Object **objects, int *numberOfObjects);
+
+/*
+ * This function reads the pictures and objects from a binary input file
+ * @param fp: the input file pointer, positioned after the file header
+ * @param pictures: pointer to the array of pictures
+ * @param objects: pointer to the array of objects
+ * @param numberOfPictures: the number of pictures from the file header, then the number of pictures read,
+ * on an error the number of pictures allocated so far
+ * @param numberOfObjects: the number of objects, on an error the number of objects allocated so far
+ * @param isSquare: whether the file has a single dimension per picture and object
+ * @return: NULL, or what could not be read
+ */
+const char *readBinaryInput(FILE *fp, Picture **pictures, Object **objects, int *numberOfPictures, int *numberOfObjects, int isSquare);
+
+/*
+ * This function reads all the input data from the input file like readInputFile, but returns an error instead of aborting.
+ * Counts and sizes that do not fit in the rest of the file are errors, so a malformed file does not allocate beyond its size.
+ * @param inputFile: the input file name
+ * @param pictures: the array of pictures, NULL on an error
+ * @param objects: the array of objects, NULL on an error
+ * @param matchingThreshold: the matching threshold
+ * @param numberOfPictures: the number of pictures, 0 on an error
+ * @param numberOfObjects: the number of objects, 0 on an error
+ * @return: NULL, or what could not be read
  */
-void readObjects(FILE *fp, Object **objects, int *numberOfObjects);
+const char *parseInputFile(const char *inputFile, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects);
 
 /*
- * This function is used to read all the input data from the input file
+ * This function is used to read all the input data from the input file, in the text or the binary input format.
+ * It aborts when the file cannot be read (see parseInputFile).
  * @param inputFile: the input file name
  * @param pictures: the array of pictures
  * @param objects: the array of objects
@@ -125,13 +336,57 @@ void readObjects(FILE *fp, Object **objects, int *numberOfObjects);
 void readInputFile(const char *inputFile, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects);
 
 /*
- * This function writes the logs to the output file
+ * This function parses the command line options
+ * @param argc: the number of arguments
+ * @param argv: the arguments
+ * @param options: the parsed options
+ * @return: void
+ */
+void parseOptions(int argc, char *argv[], Options *options);
+
+/*
+ * This function returns the output file name of a result format
+ * @param resultFormat: the result format
+ * @return: the output file name
+ */
+const char *outputFileName(int resultFormat);
+
+/*
+ * This function returns the output file name of the results of one threshold of a multi-threshold search,
+ * the output file name of the result format with the threshold before the extension (output_0.05.txt)
+ * @param resultFormat: the result format
+ * @param matchingThreshold: the matching threshold
+ * @param file: the file name, at least MAX_THRESHOLD_FILE_NAME characters
+ * @return: void
+ */
+void thresholdOutputFileName(int resultFormat, double matchingThreshold, char *file);
+
+/*
+ * This function returns an upper bound on the length of the output record of a log
+ * @param log: the log
+ * @param resultFormat: the result format
+ * @return: the maximal number of bytes formatLog can write, without the terminating null
+ */
+int maxLogRecordLength(Logs *log, int resultFormat);
+
+/*
+ * This function formats the output record of a log, without the header of the output file
+ * @param log: the log
+ * @param resultFormat: the result format
+ * @param record: the buffer to write the record to, at least maxLogRecordLength(log, resultFormat) + 1 bytes
+ * @return: the length of the record
+ */
+int formatLog(Logs *log, int resultFormat, char *record);
+
+/*
+ * This function writes the header of the output file and the logs
  * @param outputFile: the output file name
  * @param logs: the array of logs
  * @param numberOfLogs: the number of logs
+ * @param resultFormat: the result format
  * @return: void
  */
-void writeLogs(const char *outputFile, Logs **logs, int numberOfLogs);
+void writeLogs(const char *outputFile, Logs **logs, int numberOfLogs, int resultFormat);
 
 // ---------------------- MPI Functions -------------------------------
 
@@ -150,9 +405,10 @@ void sendPicture(Picture *picture, int destRank, int tag);
  * @param sourceRank: the source rank
  * @param tag: the tag
  * @param status: the status
+ * @param arena: the arena of the colors matrix, NULL to allocate it with allocateColorsMatrix
  * @return: void
  */
-void receivePicture(Picture *picture, int sourceRank, int tag, MPI_Status *status);
+void receivePicture(Picture *picture, int sourceRank, int tag, MPI_Status *status, Arena *arena);
 
 /*
  * This function sends an object to a specific rank
@@ -188,20 +444,123 @@ void sendLog(Logs *log, int destRank, int tag);
  * @param sourceRank: the source rank
  * @param tag: the tag
  * @param status: the status
+ * @param arena: the arena of the object arrays, NULL to allocate them with malloc
+ * @return: void
+ */
+void receiveLog(Logs *log, int sourceRank, int tag, MPI_Status *status, Arena *arena);
+
+/*
+ * This function sends several pictures with their indices in one packed message
+ * @param pictures: the array of pictures
+ * @param indices: the indices of the pictures to send
+ * @param numberOfPictures: the number of pictures to send
+ * @param destRank: the destination rank
+ * @param tag: the tag
+ * @return: void
+ */
+void sendPictureBatch(Picture *pictures, int *indices, int numberOfPictures, int destRank, int tag);
+
+/*
+ * This function receives the pictures sent with sendPictureBatch
+ * @param pictures: the array of pictures, allocated from the arena
+ * @param indices: the indices of the pictures, allocated from the arena
+ * @param sourceRank: the source rank
+ * @param tag: the tag
+ * @param status: the status
+ * @param arena: the arena of the pictures, their colors matrices and the indices
+ * @return: the number of pictures
+ */
+int receivePictureBatch(Picture **pictures, int **indices, int sourceRank, int tag, MPI_Status *status, Arena *arena);
+
+/*
+ * This function sends several logs in one packed message
+ * @param logs: the logs
+ * @param numberOfLogs: the number of logs
+ * @param destRank: the destination rank
+ * @param tag: the tag
+ * @return: void
+ */
+void sendLogBatch(Logs *logs, int numberOfLogs, int destRank, int tag);
+
+/*
+ * This function receives the logs sent with sendLogBatch
+ * @param logs: the logs, numberOfLogs of them
+ * @param numberOfLogs: the number of logs
+ * @param sourceRank: the source rank
+ * @param tag: the tag
+ * @param status: the status
+ * @param arena: the arena of the object arrays, NULL to allocate them with malloc
+ * @return: void
+ */
+void receiveLogBatch(Logs *logs, int numberOfLogs, int sourceRank, int tag, MPI_Status *status, Arena *arena);
+
+/*
+ * This function writes the output records of all processes to the output file using collective MPI-IO.
+ * Every process passes the records it formatted itself, each tagged with the index of its picture,
+ * and the records are placed in the file by picture index after the file header, which rank 0 writes.
+ * Must be called by all processes.
+ * @param outputFile: the output file name
+ * @param records: the records formatted by this process
+ * @param recordLengths: the length of each record
+ * @param recordIndices: the picture index of each record
+ * @param numberOfRecords: the number of records formatted by this process
+ * @param numberOfPictures: the total number of pictures
+ * @param resultFormat: the result format
  * @return: void
  */
-void receiveLog(Logs *log, int sourceRank, int tag, MPI_Status *status);
+void writeLogsParallel(const char *outputFile, char **records, int *recordLengths, int *recordIndices, int numberOfRecords, int numberOfPictures, int resultFormat);
 
 // ---------------------- OpenMP Functions -------------------------------
+/*
+ * This function calculates the matching score of an object at a position of a picture on the CPU.
+ * The CPU backends decide every position with it, so a logged score is the value the decision was made on.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param row: the upper left corner row of the object in the picture
+ * @param column: the upper left corner column of the object in the picture
+ * @return: the matching score, the average of abs((P - O) / P) over the overlapping members
+ */
+double calculateMatchingScore(Picture *picture, Object *object, int row, int column);
+
+/*
+ * This function makes a picture that shares the rows of a picture holding the positions of an object in a range of rows.
+ * A backend searching the strip finds the positions of the range, at firstRow rows less than in the picture.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param firstRow: the first position row of the strip
+ * @param numberOfRows: the number of position rows of the strip, at least 1
+ * @param strip: the strip, its colors matrix points into the picture
+ * @return: void
+ */
+void pictureStrip(Picture *picture, Object *object, int firstRow, int numberOfRows, Picture *strip);
+
 /*
  * This function calculates the matching between a picture and an object
  * @param picture: pointer to the picture
  * @param object: array of objects to be found in the picture
- * @param log: the log of the picture and the objects found in it
+ * @param log: the log of the picture and the objects found in it, in object order
+ * @param numberOfObjects: the number of objects
  * @param matching: the matching threshold
+ * @param matchingFunction: the matching backend searching one object
+ * @param numThreads: the number of threads searching objects in parallel, 0 for one thread per object
+ * @param numberOfStrips: the number of row strips every object is searched in as separate tasks, 1 for whole pictures
+ * @return: void
+ */
+void findObjectsInPicture(Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold, MatchingFunction matchingFunction, int numThreads, int numberOfStrips);
+
+/*
+ * This function searches the objects in a picture for several thresholds at once with calculateMatchingThresholds,
+ * so every position is summed once instead of once per threshold
+ * @param picture: pointer to the picture
+ * @param objects: array of objects to be found in the picture
+ * @param logs: one log per threshold, in the order of the thresholds, the found objects of every log are in object order
+ * @param numberOfObjects: the number of objects
+ * @param matchingThresholds: the matching thresholds
+ * @param numberOfThresholds: the number of thresholds
+ * @param numThreads: the number of threads searching objects in parallel, 0 for one thread per object
  * @return: void
  */
-void findObjectsInPicture(Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold);
+void findObjectsAtThresholds(Picture *picture, Object *objects, Logs *logs, int numberOfObjects, const double *matchingThresholds, int numberOfThresholds, int numThreads);
 
 // ---------------------- CUDA Functions ---------------------------------
 
@@ -0,0 +1,188 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <helper_image.h>
+#include "imageHelper.h"
+
+int quantizeGrayLevel(unsigned char grayLevel)
+{
+    return MIN_COLOR + (grayLevel * (MAX_COLOR - MIN_COLOR) + MAX_GRAY_LEVEL / 2) / MAX_GRAY_LEVEL;
+}
+
+static int hasExtension(const char *file, const char *extension)
+{
+    size_t length = strlen(file), extensionLength = strlen(extension);
+    return length > extensionLength && strcasecmp(file + length - extensionLength, extension) == 0;
+}
+
+/*
+ * This function finds the size in a raw file name, the first "_<width>x<height>" in the name
+ * @return: 1 if the name carries a size, 0 otherwise
+ */
+static int parseRawSize(const char *file, unsigned int *width, unsigned int *height)
+{
+    const char *name = strrchr(file, '/') != NULL ? strrchr(file, '/') + 1 : file;
+    for (const char *p = strchr(name, '_'); p != NULL; p = strchr(p + 1, '_'))
+        if (sscanf(p, "_%ux%u", width, height) == 2)
+            return 1;
+    return 0;
+}
+
+const char *parseImagePicture(const char *file, int ID, Picture *picture)
+{
+    unsigned char *grayLevels = NULL;
+    unsigned int width, height, channels = 1;
+
+    if (hasExtension(file, ".pgm"))
+    {
+        if (!sdkLoadPGM<unsigned char>(file, &grayLevels, &width, &height))
+            return file;
+    }
+    else
+    {
+        unsigned int length;
+        struct stat fileStatus;
+        if (!parseRawSize(file, &width, &height) || width == 0 || height == 0 || stat(file, &fileStatus) != 0)
+            return file;
+        channels = fileStatus.st_size / ((off_t)width * height);
+        if (channels != 1 && channels != 3 && channels != 4)
+            return "channels of raw image";
+        if (!sdkReadFileBlocks<unsigned char>(file, &grayLevels, &length, 0, width * height * channels, false))
+            return file;
+        if (length != width * height * channels)
+        {
+            free(grayLevels);
+            return file;
+        }
+    }
+
+    picture->ID = ID;
+    allocatePicture(picture, width, height);
+    for (int i = 0; i < (int)height; i++)
+        for (int j = 0; j < (int)width; j++)
+        {
+            unsigned char *pixel = grayLevels + ((size_t)i * width + j) * channels;
+            int grayLevel = channels == 1 ? pixel[0] : (pixel[0] + pixel[1] + pixel[2]) / 3;
+            picture->colorsMatrix[i * picture->pitch + j] = quantizeGrayLevel(grayLevel);
+        }
+    free(grayLevels);
+    return NULL;
+}
+
+void loadImagePicture(const char *file, int ID, Picture *picture)
+{
+    const char *error = parseImagePicture(file, ID, picture);
+    if (error != NULL)
+        checkRead(0, 1, error);
+}
+
+static int compareFileNames(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+void listImageFiles(const char *path, char ***files, int *numberOfFiles)
+{
+    struct stat pathStatus;
+    if (stat(path, &pathStatus) != 0)
+        checkRead(0, 1, path);
+
+    if (!S_ISDIR(pathStatus.st_mode))
+    {
+        *files = (char **)realloc(*files, (*numberOfFiles + 1) * sizeof(char *));
+        checkMalloc(*files, "image file names");
+        (*files)[(*numberOfFiles)++] = strdup(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    checkMalloc(directory, path);
+    int first = *numberOfFiles;
+    for (struct dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory))
+    {
+        if (!hasExtension(entry->d_name, ".pgm") && !hasExtension(entry->d_name, ".raw"))
+            continue;
+        *files = (char **)realloc(*files, (*numberOfFiles + 1) * sizeof(char *));
+        checkMalloc(*files, "image file names");
+        (*files)[*numberOfFiles] = (char *)malloc(strlen(path) + strlen(entry->d_name) + 2);
+        checkMalloc((*files)[*numberOfFiles], "image file name");
+        sprintf((*files)[(*numberOfFiles)++], "%s/%s", path, entry->d_name);
+    }
+    closedir(directory);
+    qsort(*files + first, *numberOfFiles - first, sizeof(char *), compareFileNames);
+}
+
+void cropObject(Picture *picture, int row, int column, int width, int height, int ID, Object *object)
+{
+    if (row < 0 || column < 0 || width < 1 || height < 1 || row + height > picture->height || column + width > picture->width)
+        checkRead(0, 1, "object crop inside its picture");
+
+    object->ID = ID;
+    allocateObject(object, width, height);
+    for (int i = 0; i < height; i++)
+        memcpy(object->subColorsMatrix + i * object->pitch, picture->colorsMatrix + (row + i) * picture->pitch + column, width * sizeof(int));
+}
+
+void readImageInput(Options *options, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects)
+{
+    char **files = NULL;
+    int numberOfFiles = 0;
+
+    *matchingThreshold = options->matchingThreshold >= 0 ? options->matchingThreshold : DEFAULT_MATCHING_THRESHOLD;
+
+    for (int i = 0; i < options->numberOfImagePaths; i++)
+        listImageFiles(options->imagePaths[i], &files, &numberOfFiles);
+    *numberOfPictures = numberOfFiles;
+    *pictures = (Picture *)malloc(numberOfFiles * sizeof(Picture));
+    checkMalloc(*pictures, "pictures array");
+    for (int i = 0; i < numberOfFiles; i++)
+    {
+        loadImagePicture(files[i], i + 1, &(*pictures)[i]);
+        printf("Picture %d: %s (%dx%d)\n", i + 1, files[i], (*pictures)[i].width, (*pictures)[i].height);
+        free(files[i]);
+    }
+    free(files);
+
+    // whole object images first, then the objects cropped out of pictures
+    files = NULL;
+    numberOfFiles = 0;
+    for (int i = 0; i < options->numberOfObjectImagePaths; i++)
+        listImageFiles(options->objectImagePaths[i], &files, &numberOfFiles);
+    *numberOfObjects = numberOfFiles + options->numberOfObjectCrops;
+    *objects = (Object *)malloc((*numberOfObjects + 1) * sizeof(Object));
+    checkMalloc(*objects, "objects array");
+    for (int i = 0; i < numberOfFiles; i++)
+    {
+        Picture image;
+        loadImagePicture(files[i], i + 1, &image);
+        (*objects)[i].ID = i + 1;
+        (*objects)[i].width = image.width;
+        (*objects)[i].height = image.height;
+        (*objects)[i].pitch = image.pitch;
+        (*objects)[i].subColorsMatrix = image.colorsMatrix;
+        (*objects)[i].colorCounts = NULL;
+        (*objects)[i].visitBlocks = NULL;
+        printf("Object %d: %s (%dx%d)\n", i + 1, files[i], image.width, image.height);
+        free(files[i]);
+    }
+    free(files);
+
+    for (int i = 0; i < options->numberOfObjectCrops; i++)
+    {
+        // the height is optional, square crops give only the width
+        int pictureID, row, column, width, height;
+        int ID = numberOfFiles + i + 1;
+        int read = sscanf(options->objectCrops[i], "%d,%d,%d,%d,%d", &pictureID, &row, &column, &width, &height);
+        if (read == 4)
+            height = width;
+        else
+            checkRead(read, 5, "object crop picture,row,column,width[,height]");
+        if (pictureID < 1 || pictureID > *numberOfPictures)
+            checkRead(pictureID, 1, "picture ID of object crop");
+        cropObject(&(*pictures)[pictureID - 1], row, column, width, height, ID, &(*objects)[ID - 1]);
+        printf("Object %d: picture %d Position(%d,%d) (%dx%d)\n", ID, pictureID, row, column, width, height);
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "helper.h"
+
+#define MAX_GRAY_LEVEL 255
+#define DEFAULT_MATCHING_THRESHOLD 0.1
+
+/*
+ * This function maps an 8-bit gray level to the color range [MIN_COLOR, MAX_COLOR], rounding to the nearest color
+ * @param grayLevel: the gray level, 0 to MAX_GRAY_LEVEL
+ * @return: the color
+ */
+int quantizeGrayLevel(unsigned char grayLevel);
+
+/*
+ * This function loads an 8-bit grayscale image into a picture. PGM files are read with sdkLoadPGM,
+ * raw files with sdkReadFileBlocks and must carry their size in the name, like PCB_1280x720_8u.raw.
+ * Raw files with 3 or 4 channels are converted to gray. The picture keeps the width and height of the image.
+ * @param file: the image file name
+ * @param ID: the picture ID
+ * @param picture: the picture
+ * @return: void
+ */
+void loadImagePicture(const char *file, int ID, Picture *picture);
+
+/*
+ * This function loads an image into a picture like loadImagePicture, but returns an error instead of aborting
+ * @param file: the image file name
+ * @param ID: the picture ID
+ * @param picture: the picture, allocated only on success
+ * @return: NULL, or what could not be read
+ */
+const char *parseImagePicture(const char *file, int ID, Picture *picture);
+
+/*
+ * This function lists the image files of a path: the path itself if it is a file,
+ * or the PGM and raw files of a directory sorted by name
+ * @param path: the file or directory
+ * @param files: pointer to the array of file names, appended to
+ * @param numberOfFiles: the number of file names
+ * @return: void
+ */
+void listImageFiles(const char *path, char ***files, int *numberOfFiles);
+
+/*
+ * This function crops an object out of a picture
+ * @param picture: the picture
+ * @param row: the upper left corner row of the object in the picture
+ * @param column: the upper left corner column of the object in the picture
+ * @param width: the object width
+ * @param height: the object height
+ * @param ID: the object ID
+ * @param object: the object
+ * @return: void
+ */
+void cropObject(Picture *picture, int row, int column, int width, int height, int ID, Object *object);
+
+/*
+ * This function is used to read all the input data from images instead of an input file.
+ * Pictures come from the image paths of the options, objects from the object image paths and the object crops.
+ * @param options: the options
+ * @param pictures: the array of pictures
+ * @param objects: the array of objects
+ * @param matchingThreshold: the matching threshold
+ * @param numberOfPictures: the number of pictures
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void readImageInput(Options *options, Picture **pictures, Object **objects, double *matchingThreshold, int *numberOfPictures, int *numberOfObjects);
@@ -2,9 +2,479 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <limits.h>
 #include <time.h>
 #include <omp.h>
 #include "helper.h"
+#include "cpuHelper.h"
+#include "imageHelper.h"
+#include "serviceHelper.h"
+#include "snapshotHelper.h"
+#include "cacheHelper.h"
+#include "scoreMapHelper.h"
+#include "orientationHelper.h"
+#include "maskHelper.h"
+#include "arenaHelper.h"
+#include "numaHelper.h"
+#include "trace.h"
+
+/*
+ * This function allocates the logs the master process collects for a set of pictures. The object arrays
+ * are allocated from the same arena when a log is received or looked up, and released with it.
+ * @param pictures: the array of pictures
+ * @param numberOfPictures: the number of pictures
+ * @param numberOfResultSets: the number of thresholds, the logs of threshold k start at k * numberOfPictures
+ * @param arena: the arena of the logs
+ * @return: the array of logs
+ */
+static Logs *allocateSearchLogs(Picture *pictures, int numberOfPictures, int numberOfResultSets, Arena *arena)
+{
+    Logs *searchLogs = (Logs *)arenaAllocate(arena, numberOfResultSets * numberOfPictures * sizeof(Logs));
+
+    for (int i = 0; i < numberOfResultSets * numberOfPictures; i++)
+    {
+        searchLogs[i].pictureID = pictures[i % numberOfPictures].ID;
+        searchLogs[i].numObjectsFound = 0;
+        searchLogs[i].objectIDs = NULL;
+        searchLogs[i].objectPositions = NULL;
+        searchLogs[i].objectScores = NULL;
+        searchLogs[i].objectTimes = NULL;
+        searchLogs[i].objectOrientations = NULL;
+    }
+    return searchLogs;
+}
+
+/*
+ * This function estimates the cost of searching the objects in a picture, the number of color comparisons
+ * of all positions, (N - d + 1)^2 * d^2 per object for square pictures and objects
+ * @param picture: pointer to the picture
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: the estimated cost
+ */
+static double estimatePictureCost(Picture *picture, Object *objects, int numberOfObjects)
+{
+    double cost = 0;
+    for (int i = 0; i < numberOfObjects; i++)
+        if (objects[i].width <= picture->width && objects[i].height <= picture->height)
+            cost += (double)(picture->width - objects[i].width + 1) * (picture->height - objects[i].height + 1) * objects[i].width * objects[i].height;
+    return cost;
+}
+
+struct PendingPictureStruct
+{
+    int index;
+    double cost;
+};
+typedef struct PendingPictureStruct PendingPicture;
+
+static int compareLargestFirst(const void *a, const void *b)
+{
+    const PendingPicture *first = (const PendingPicture *)a, *second = (const PendingPicture *)b;
+    if (first->cost != second->cost)
+        return first->cost < second->cost ? 1 : -1;
+    return first->index - second->index;
+}
+
+/*
+ * This function sorts the pending pictures by decreasing estimated cost, so the longest searches start first
+ * and the last pictures to finish are short ones (longest processing time first)
+ * @param pendingPictures: the indices of the pending pictures
+ * @param numberOfPending: the number of pending pictures
+ * @param pictures: the array of pictures
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+static void sortLargestFirst(int *pendingPictures, int numberOfPending, Picture *pictures, Object *objects, int numberOfObjects)
+{
+    PendingPicture *pending = (PendingPicture *)malloc((numberOfPending + 1) * sizeof(PendingPicture));
+    checkMalloc(pending, "pending pictures costs");
+    for (int i = 0; i < numberOfPending; i++)
+    {
+        pending[i].index = pendingPictures[i];
+        pending[i].cost = estimatePictureCost(&pictures[pendingPictures[i]], objects, numberOfObjects);
+    }
+    qsort(pending, numberOfPending, sizeof(PendingPicture), compareLargestFirst);
+    for (int i = 0; i < numberOfPending; i++)
+        pendingPictures[i] = pending[i].index;
+    free(pending);
+}
+
+/*
+ * This function sends the next pending pictures to a worker process. With batching, consecutive pending pictures
+ * go out together while their estimated cost stays within the batch cost, as long as enough pictures remain
+ * for the final phase, which is always sent one picture at a time.
+ * @param destRank: the worker process
+ * @param pictures: the array of pictures
+ * @param pendingPictures: the indices of the pending pictures in sending order
+ * @param numberOfPending: the number of pending pictures
+ * @param pendingIndex: the position of the next pending picture, advanced past the sent pictures
+ * @param costs: the estimated cost of every pending picture, NULL without batching
+ * @param batchCost: the largest estimated cost of a batch
+ * @param size: the number of processes
+ * @param assignedStart: the position of the first pending picture sent to each process
+ * @param assignedCount: the number of pictures sent to each process
+ * @return: void
+ */
+static void sendPendingPictures(int destRank, Picture *pictures, int *pendingPictures, int numberOfPending, int *pendingIndex, double *costs,
+                                double batchCost, int size, int *assignedStart, int *assignedCount)
+{
+    int start = *pendingIndex;
+    int count = 1;
+    double stageStartTime = traceNow();
+
+    if (costs != NULL)
+    {
+        double cost = costs[start];
+        while (start + count < numberOfPending && count < MAX_BATCH_PICTURES && cost + costs[start + count] <= batchCost &&
+               numberOfPending - (start + count + 1) >= size - 1)
+            cost += costs[start + count++];
+    }
+    *pendingIndex += count;
+    assignedStart[destRank] = start;
+    assignedCount[destRank] = count;
+
+    if (count > 1)
+    {
+        // the batch size takes the place of the picture index, the pictures follow in one message
+        MPI_Send(&count, 1, MPI_INT, destRank, BATCH_TAG, MPI_COMM_WORLD);
+        sendPictureBatch(pictures, pendingPictures + start, count, destRank, BATCH_TAG);
+        traceRecord("send batch", stageStartTime, traceNow(), pictures[pendingPictures[start]].ID);
+        return;
+    }
+
+    int pictureIndex = pendingPictures[start];
+    int tag = numberOfPending - *pendingIndex < size - 1 ? LAST_PICTURE_TAG : PICTURE_TAG;
+    MPI_Send(&pictureIndex, 1, MPI_INT, destRank, tag, MPI_COMM_WORLD);
+    sendPicture(&pictures[pictureIndex], destRank, tag);
+    traceRecord("send picture", stageStartTime, traceNow(), pictures[pictureIndex].ID);
+}
+
+/*
+ * This function sends the pending pictures to the worker processes, the next pictures to the process that finished first,
+ * and stores the log of every picture at its index, so logs are in input order.
+ * A multi-threshold search receives one log per threshold, stored numberOfPictures apart.
+ * The pictures after which fewer pictures remain than there are workers are sent with LAST_PICTURE_TAG,
+ * so a worker splits them over all its threads instead of waiting for the final pictures of the others.
+ * With batching, small pictures are sent in batches and their logs come back in one message per batch.
+ * @param pictures: the array of pictures
+ * @param numberOfPictures: the number of pictures
+ * @param pendingPictures: the indices of the pictures to search
+ * @param numberOfPending: the number of pictures to search
+ * @param searchLogs: the array of logs
+ * @param size: the number of processes
+ * @param options: the options
+ * @param cache: the result cache the logs are stored in, NULL without one
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param arena: the arena of the object arrays of the logs
+ * @return: void
+ */
+static void searchPendingPictures(Picture *pictures, int numberOfPictures, int *pendingPictures, int numberOfPending, Logs *searchLogs, int size,
+                                  Options *options, ResultCache *cache, Object *objects, int numberOfObjects, Arena *arena)
+{
+    MPI_Status status;
+    int numberOfResultSets = options->numberOfThresholds > 1 ? options->numberOfThresholds : 1;
+    int pendingIndex = 0;
+    int logsIndex = 0;
+    double stageStartTime;
+
+    // the pending pictures each process is working on, so logs are stored in input order
+    int *assignedStart = (int *)malloc(size * sizeof(int));
+    checkMalloc(assignedStart, "assigned pictures array");
+    int *assignedCount = (int *)malloc(size * sizeof(int));
+    checkMalloc(assignedCount, "assigned picture counts array");
+
+    if (options->dispatchOrder == DISPATCH_LARGEST_FIRST)
+        sortLargestFirst(pendingPictures, numberOfPending, pictures, objects, numberOfObjects);
+
+    // a batch costs at most BATCH_COST, and every worker gets at least BATCHES_PER_WORKER batches to balance the load
+    double *costs = NULL;
+    double batchCost = 0;
+    if (options->batchPictures)
+    {
+        costs = (double *)malloc((numberOfPending + 1) * sizeof(double));
+        checkMalloc(costs, "pending picture costs");
+        double totalCost = 0;
+        for (int i = 0; i < numberOfPending; i++)
+            totalCost += costs[i] = estimatePictureCost(&pictures[pendingPictures[i]], objects, numberOfObjects);
+        batchCost = fmin(BATCH_COST, totalCost / (BATCHES_PER_WORKER * (size - 1)));
+    }
+
+    // send each process the first pictures to work on
+    for (int i = 1; i < size && pendingIndex < numberOfPending; i++)
+        sendPendingPictures(i, pictures, pendingPictures, numberOfPending, &pendingIndex, costs, batchCost, size, assignedStart, assignedCount);
+
+    // while there are pictures to be processed
+    while (logsIndex < numberOfPending)
+    {
+        // receive logs from process, or only a completion notice when the process writes its own output
+        stageStartTime = traceNow();
+        if (options->parallelOutput)
+        {
+            int completedIndex;
+            MPI_Recv(&completedIndex, 1, MPI_INT, MPI_ANY_SOURCE, LOGS_TAG, MPI_COMM_WORLD, &status);
+        }
+        else
+        {
+            MPI_Probe(MPI_ANY_SOURCE, LOGS_TAG, MPI_COMM_WORLD, &status);
+            int source = status.MPI_SOURCE;
+            int start = assignedStart[source], count = assignedCount[source];
+            Logs *receivedLogs = (Logs *)arenaAllocate(arena, count * numberOfResultSets * sizeof(Logs));
+            if (count > 1)
+                receiveLogBatch(receivedLogs, count * numberOfResultSets, source, LOGS_TAG, &status, arena);
+            else
+                for (int k = 0; k < numberOfResultSets; k++)
+                    receiveLog(&receivedLogs[k], source, LOGS_TAG, &status, arena);
+
+            // the logs of a batch are picture by picture, every picture with one log per threshold
+            for (int p = 0; p < count; p++)
+            {
+                int pictureIndex = pendingPictures[start + p];
+                for (int k = 0; k < numberOfResultSets; k++)
+                    searchLogs[k * numberOfPictures + pictureIndex] = receivedLogs[p * numberOfResultSets + k];
+                if (cache != NULL)
+                    storeResultCache(cache, &pictures[pictureIndex], &searchLogs[pictureIndex]);
+            }
+        }
+        traceRecord("receive log", stageStartTime, traceNow(), pictures[pendingPictures[assignedStart[status.MPI_SOURCE]]].ID);
+        logsIndex += assignedCount[status.MPI_SOURCE];
+
+        if (pendingIndex < numberOfPending)
+            sendPendingPictures(status.MPI_SOURCE, pictures, pendingPictures, numberOfPending, &pendingIndex, costs, batchCost, size, assignedStart, assignedCount);
+    }
+    free(assignedStart);
+    free(assignedCount);
+    free(costs);
+}
+
+/*
+ * This function splits the pictures whose estimated cost is more than the share of one worker into row strips,
+ * so several workers search one large picture. A strip holds a range of position rows and a halo of the height
+ * of the tallest object minus 1 rows below them, so every position of the range is inside the strip for every object.
+ * The first strip in row order that holds a match of an object holds its first match in the picture.
+ * @param pictures: the array of pictures
+ * @param numberOfPictures: the number of pictures
+ * @param pendingPictures: the indices of the pictures to search
+ * @param numberOfPending: the number of pictures to search
+ * @param searchLogs: the array of logs
+ * @param size: the number of processes
+ * @param options: the options
+ * @param cache: the result cache the merged logs are stored in, NULL without one
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param arena: the arena of the logs
+ * @return: void
+ */
+static void searchSplitPictures(Picture *pictures, int numberOfPictures, int *pendingPictures, int numberOfPending, Logs *searchLogs, int size,
+                                Options *options, ResultCache *cache, Object *objects, int numberOfObjects, Arena *arena)
+{
+    int numberOfResultSets = options->numberOfThresholds > 1 ? options->numberOfThresholds : 1;
+    int workers = size - 1;
+    int minHeight = INT_MAX, maxHeight = 0;
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        minHeight = objects[i].height < minHeight ? objects[i].height : minHeight;
+        maxHeight = objects[i].height > maxHeight ? objects[i].height : maxHeight;
+    }
+
+    // a picture gets one strip per worker share of the total cost, at most one per worker and per position row
+    double totalCost = 0;
+    int *strips = (int *)malloc((numberOfPending + 1) * sizeof(int));
+    checkMalloc(strips, "strip counts array");
+    for (int p = 0; p < numberOfPending; p++)
+        totalCost += estimatePictureCost(&pictures[pendingPictures[p]], objects, numberOfObjects);
+    int numberOfWork = numberOfPictures;
+    for (int p = 0; p < numberOfPending; p++)
+    {
+        Picture *picture = &pictures[pendingPictures[p]];
+        int positionRows = picture->height - minHeight + 1;
+        double share = totalCost > 0 ? estimatePictureCost(picture, objects, numberOfObjects) * workers / totalCost : 0;
+        strips[p] = (int)fmin(fmin(floor(share + 0.5), workers), positionRows);
+        if (strips[p] < 2)
+            strips[p] = 1;
+        else
+            numberOfWork += strips[p];
+    }
+
+    // the strips are views of the pictures after them, a strip shares the rows of its picture
+    Picture *workPictures = (Picture *)arenaAllocate(arena, numberOfWork * sizeof(Picture));
+    int *stripPictures = (int *)arenaAllocate(arena, numberOfWork * sizeof(int));
+    int *stripFirstRows = (int *)arenaAllocate(arena, numberOfWork * sizeof(int));
+    int *workPending = (int *)arenaAllocate(arena, numberOfWork * sizeof(int));
+    Logs *workLogs = (Logs *)arenaAllocate(arena, numberOfResultSets * numberOfWork * sizeof(Logs));
+    int numberOfWorkPending = 0;
+    int strip = numberOfPictures;
+    memcpy(workPictures, pictures, numberOfPictures * sizeof(Picture));
+    for (int p = 0; p < numberOfPending; p++)
+    {
+        int pictureIndex = pendingPictures[p];
+        Picture *picture = &pictures[pictureIndex];
+        if (strips[p] == 1)
+        {
+            workPending[numberOfWorkPending++] = pictureIndex;
+            continue;
+        }
+        int positionRows = picture->height - minHeight + 1;
+        for (int s = 0; s < strips[p]; s++, strip++)
+        {
+            int firstRow = (long long)s * positionRows / strips[p];
+            int lastRow = (long long)(s + 1) * positionRows / strips[p];
+            workPictures[strip] = *picture;
+            workPictures[strip].colorsMatrix = picture->colorsMatrix + (size_t)firstRow * picture->pitch;
+            workPictures[strip].height = (int)fmin(lastRow - firstRow + maxHeight - 1, picture->height - firstRow);
+            stripPictures[strip] = pictureIndex;
+            stripFirstRows[strip] = firstRow;
+            workPending[numberOfWorkPending++] = strip;
+        }
+    }
+
+    searchPendingPictures(workPictures, numberOfWork, workPending, numberOfWorkPending, workLogs, size, options, NULL, objects, numberOfObjects, arena);
+
+    // whole pictures keep their logs, the logs of the strips of a picture are merged in object order
+    strip = numberOfPictures;
+    for (int p = 0; p < numberOfPending; p++)
+    {
+        int pictureIndex = pendingPictures[p];
+        for (int k = 0; k < numberOfResultSets; k++)
+        {
+            Logs *log = &searchLogs[k * numberOfPictures + pictureIndex];
+            if (strips[p] == 1)
+            {
+                *log = workLogs[k * numberOfWork + pictureIndex];
+                continue;
+            }
+            log->numObjectsFound = 0;
+            log->searchTime = 0;
+            allocateLogArrays(log, numberOfObjects, arena);
+            for (int s = 0; s < strips[p]; s++)
+                log->searchTime += workLogs[k * numberOfWork + strip + s].searchTime;
+            for (int i = 0; i < numberOfObjects; i++)
+            {
+                int found = 0;
+                for (int s = 0; s < strips[p] && !found; s++)
+                {
+                    Logs *stripLog = &workLogs[k * numberOfWork + strip + s];
+                    for (int j = 0; j < stripLog->numObjectsFound && !found; j++)
+                        if (stripLog->objectIDs[j] == objects[i].ID)
+                        {
+                            log->objectIDs[log->numObjectsFound] = objects[i].ID;
+                            log->objectPositions[log->numObjectsFound].row = stripLog->objectPositions[j].row + stripFirstRows[strip + s];
+                            log->objectPositions[log->numObjectsFound].column = stripLog->objectPositions[j].column;
+                            log->objectScores[log->numObjectsFound] = stripLog->objectScores[j];
+                            log->objectTimes[log->numObjectsFound] = stripLog->objectTimes[j];
+                            log->objectOrientations[log->numObjectsFound] = stripLog->objectOrientations[j];
+                            log->numObjectsFound++;
+                            found = 1;
+                        }
+                }
+            }
+        }
+        if (cache != NULL)
+            storeResultCache(cache, &pictures[pictureIndex], &searchLogs[pictureIndex]);
+        if (strips[p] > 1)
+            strip += strips[p];
+    }
+    free(strips);
+}
+
+/*
+ * This function sends the pictures to the worker processes and collects their logs, see searchPendingPictures.
+ * Pictures found in the result cache or with a score map are not sent, the logs of the others are stored in the cache.
+ * With picture splitting, large pictures are searched in strips by several workers, see searchSplitPictures.
+ * @param pictures: the array of pictures
+ * @param numberOfPictures: the number of pictures
+ * @param searchLogs: the array of logs
+ * @param size: the number of processes
+ * @param options: the options
+ * @param cache: the result cache, NULL without one
+ * @param scoreMaps: the score maps, NULL without them
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold, for the score maps
+ * @param arena: the arena of the object arrays of the logs
+ * @return: void
+ */
+static void dispatchPictures(Picture *pictures, int numberOfPictures, Logs *searchLogs, int size, Options *options, ResultCache *cache,
+                             ScoreMaps *scoreMaps, Object *objects, int numberOfObjects, double matchingThreshold, Arena *arena)
+{
+    int numberOfPending = 0;
+    double stageStartTime;
+
+    // the indices of the pictures that have to be searched
+    int *pendingPictures = (int *)malloc((numberOfPictures + 1) * sizeof(int));
+    checkMalloc(pendingPictures, "pending pictures array");
+    stageStartTime = traceNow();
+    for (int i = 0; i < numberOfPictures; i++)
+        if ((cache == NULL || !lookupResultCache(cache, &pictures[i], &searchLogs[i], arena)) &&
+            (scoreMaps == NULL || !lookupScoreMap(scoreMaps, &pictures[i], objects, numberOfObjects, matchingThreshold, &searchLogs[i], arena)))
+            pendingPictures[numberOfPending++] = i;
+    if (cache != NULL || scoreMaps != NULL)
+        traceRecord("lookup cache", stageStartTime, traceNow(), -1);
+
+    // the workers write the output of whole pictures themselves with parallel output, so strips cannot be merged
+    if (options->splitPictures && !options->parallelOutput)
+        searchSplitPictures(pictures, numberOfPictures, pendingPictures, numberOfPending, searchLogs, size, options, cache, objects, numberOfObjects, arena);
+    else
+        searchPendingPictures(pictures, numberOfPictures, pendingPictures, numberOfPending, searchLogs, size, options, cache, objects, numberOfObjects, arena);
+    free(pendingPictures);
+}
+
+/*
+ * This function runs the service mode of the master process: it searches the pictures of every job
+ * of the spool directory with the resident objects and publishes the result of each job, until it is stopped
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param size: the number of processes
+ * @param options: the options
+ * @param cache: the result cache, NULL without one
+ * @param scoreMaps: the score maps, NULL without them
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+static void serveJobs(Object *objects, int numberOfObjects, int size, Options *options, ResultCache *cache, ScoreMaps *scoreMaps, double matchingThreshold)
+{
+    char jobName[MAX_SPOOL_PATH], jobFile[MAX_SPOOL_PATH];
+    // the logs of a job are released at once before the next job, which reuses their memory
+    Arena jobArena;
+    initializeArena(&jobArena, ARENA_BLOCK_SIZE);
+
+    prepareSpoolDirectory(options->spoolDirectory);
+    printf("Serving %d objects from %s \r \n", numberOfObjects, options->spoolDirectory);
+    fflush(stdout);
+
+    while (waitForSpoolJob(options->spoolDirectory, jobName, jobFile) == SPOOL_JOB)
+    {
+        Picture *pictures;
+        int numberOfPictures;
+        double jobStartTime = MPI_Wtime();
+        double stageStartTime = traceNow();
+
+        const char *error = readJobPictures(jobFile, &pictures, &numberOfPictures);
+        traceRecord("parse job", stageStartTime, traceNow(), -1);
+        if (error != NULL)
+        {
+            // a malformed job is reported and dropped, the service goes on with the next one
+            publishJobError(options->spoolDirectory, jobName, jobFile, error);
+            printf("Job %s: error reading %s \r \n", jobName, error);
+            fflush(stdout);
+            continue;
+        }
+        resetArena(&jobArena);
+        Logs *searchLogs = allocateSearchLogs(pictures, numberOfPictures, 1, &jobArena);
+        dispatchPictures(pictures, numberOfPictures, searchLogs, size, options, cache, scoreMaps, objects, numberOfObjects, matchingThreshold, &jobArena);
+
+        stageStartTime = traceNow();
+        publishJobResult(options->spoolDirectory, jobName, jobFile, searchLogs, numberOfPictures, options->resultFormat);
+        traceRecord("write logs", stageStartTime, traceNow(), -1);
+        printf("Job %s: %d pictures in %f \r \n", jobName, numberOfPictures, MPI_Wtime() - jobStartTime);
+        fflush(stdout);
+
+        freePictures(pictures, numberOfPictures);
+    }
+    freeArena(&jobArena);
+}
 
 int main(int argc, char *argv[])
 {
@@ -12,16 +482,23 @@ int main(int argc, char *argv[])
     int numberOfPictures, numberOfObjects;
     double matchingThreshold;
     int pictureIndex = 0;
-    int logsIndex = 0;
     Picture *pictures;
     Object *objects;
     Logs *searchLogs;
+    Options options;
+    ObjectSnapshot objectSnapshot;
+    Arena arena; // the logs on the master process, the picture and its logs on the worker processes
     MPI_Status status;
 
     // Initialize MPI
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
+    parseOptions(argc, argv, &options);
+    int numberOfResultSets = options.numberOfThresholds > 1 ? options.numberOfThresholds : 1;
+    if (options.numa)
+        enableNumaPlacement();
+    initializeArena(&arena, ARENA_BLOCK_SIZE);
 
     // Check if number of processes is greater than 2
     if (size < 2)
@@ -30,23 +507,32 @@ int main(int argc, char *argv[])
         MPI_Finalize();
         return 0;
     }
+    if (options.trace)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        traceEnable();
+    }
     double startTime = MPI_Wtime();
+    double stageStartTime = traceNow();
     // Read input files and allocate memory for logs
     if (rank == 0)
     {
-        // read input file
-        readInputFile(INPUT_FILE, &pictures, &objects, &matchingThreshold, &numberOfPictures, &numberOfObjects);
-        // allocate memory for logs array and initialize it
-        searchLogs = (Logs *)malloc(numberOfPictures * sizeof(Logs));
-        checkMalloc(searchLogs, "search logs array");
-
-        for (int i = 0; i < numberOfPictures; i++)
+        // read input file, or the images given instead of it
+        if (options.numberOfImagePaths > 0)
+            readImageInput(&options, &pictures, &objects, &matchingThreshold, &numberOfPictures, &numberOfObjects);
+        else
+            readInputFile(options.inputFile, &pictures, &objects, &matchingThreshold, &numberOfPictures, &numberOfObjects);
+        if (options.matchingThreshold >= 0)
+            matchingThreshold = options.matchingThreshold;
+        traceRecord("parse input", stageStartTime, traceNow(), -1);
+        // a service searches the pictures of its jobs, the ones of the input are not searched
+        if (options.spoolDirectory != NULL)
         {
-            searchLogs[i].pictureID = pictures[i].ID;
-            searchLogs[i].numObjectsFound = 0;
-            searchLogs[i].objectIDs = NULL;
-            searchLogs[i].objectPositions = (Position *)malloc(sizeof(Position) * numberOfObjects);
+            freePictures(pictures, numberOfPictures);
+            pictures = NULL;
+            numberOfPictures = 0;
         }
+        searchLogs = allocateSearchLogs(pictures, numberOfPictures, numberOfResultSets, &arena);
     }
 
     // // Broadcast matching threshold, number of pictures, number of objects ans the objects to all processes
@@ -54,8 +540,21 @@ int main(int argc, char *argv[])
     MPI_Bcast(&numberOfPictures, 1, MPI_INT, 0, MPI_COMM_WORLD);
     MPI_Bcast(&numberOfObjects, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-    if (rank == 0)
+    stageStartTime = traceNow();
+    if (options.objectSnapshot != NULL)
     {
+        // every process maps the objects, the ones of the input are not used
+        if (rank == 0)
+            freeObjects(objects, numberOfObjects);
+        loadObjectSnapshot(options.objectSnapshot, &objectSnapshot);
+        objects = objectSnapshot.objects;
+        numberOfObjects = objectSnapshot.numberOfObjects;
+    }
+    else if (rank == 0)
+    {
+        if (options.saveObjectSnapshot != NULL)
+            writeObjectSnapshot(options.saveObjectSnapshot, objects, numberOfObjects);
+
         // send all objects to all processes
         for (int i = 1; i < size; i++)
             for (int j = 0; j < numberOfObjects; j++)
@@ -63,103 +562,218 @@ int main(int argc, char *argv[])
     }
     else
     {
-        objects = (Object *)malloc(numberOfObjects * sizeof(Object));
+        objects = (Object *)malloc((numberOfObjects + 1) * sizeof(Object));
         checkMalloc(objects, "objects array");
 
+        // the color histograms of the objects are computed once, for the histogram backend
         for (int i = 0; i < numberOfObjects; i++)
+        {
             receiveObject(&objects[i], 0, OBJECT_TAG, &status);
+            computeColorCounts(&objects[i]);
+        }
     }
+    traceRecord("distribute objects", stageStartTime, traceNow(), -1);
+
+    // the threads searching the pictures are pinned once, later teams of the same size reuse them
+    pinThreads(options.numThreads > 0 ? options.numThreads : numberOfObjects);
 
     // master process
     if (rank == 0)
     {
+        // the master only sees the logs when it writes the output, so the cache needs serial output,
+        // and it holds the logs of one threshold
+        int useCache = options.cacheDirectory != NULL && !options.parallelOutput && numberOfResultSets == 1;
+        ResultCache cache;
+        if (useCache)
+            openResultCache(&cache, options.cacheDirectory, options.cacheMegabytes << 20, objects, numberOfObjects, matchingThreshold);
+        ResultCache *resultCache = useCache ? &cache : NULL;
 
-        // send each process the first picture to work on
-        for (int i = 1; i < size && pictureIndex < numberOfPictures; i++)
-        {
-            MPI_Send(&pictureIndex, 1, MPI_INT, i, PICTURE_TAG, MPI_COMM_WORLD);
-            sendPicture(&pictures[pictureIndex], i, PICTURE_TAG);
-            pictureIndex++;
-        }
-
-        // while there are pictures to be processed
-        while (pictureIndex < numberOfPictures)
-        {
-            // receive logs from process
-            receiveLog(&searchLogs[logsIndex], MPI_ANY_SOURCE, LOGS_TAG, &status);
-            logsIndex++;
-
-            // send update picture index to process
-            MPI_Send(&pictureIndex, 1, MPI_INT, status.MPI_SOURCE, 0, MPI_COMM_WORLD);
+        // score maps answer pictures searched before with any threshold, they also need serial output
+        int useScoreMaps = options.scoreMapDirectory != NULL && !options.parallelOutput && numberOfResultSets == 1;
+        ScoreMaps scoreMaps;
+        if (useScoreMaps)
+            openScoreMaps(&scoreMaps, options.scoreMapDirectory, objects, numberOfObjects);
+        ScoreMaps *pictureScoreMaps = useScoreMaps ? &scoreMaps : NULL;
 
-            // send next picture to process
-            sendPicture(&pictures[pictureIndex], status.MPI_SOURCE, PICTURE_TAG);
-            pictureIndex++;
-        }
-        // receive logs from all processes
-        while (logsIndex < numberOfPictures)
-        {
-            receiveLog(&searchLogs[logsIndex], MPI_ANY_SOURCE, LOGS_TAG, &status);
-            logsIndex++;
-        }
+        if (options.spoolDirectory != NULL)
+            serveJobs(objects, numberOfObjects, size, &options, resultCache, pictureScoreMaps, matchingThreshold);
+        else
+            dispatchPictures(pictures, numberOfPictures, searchLogs, size, &options, resultCache, pictureScoreMaps, objects, numberOfObjects, matchingThreshold, &arena);
+        if (resultCache != NULL)
+            closeResultCache(resultCache);
 
         // send terminate signal to all processes
         for (int i = 1; i < size; i++)
             MPI_Send(&pictureIndex, 1, MPI_INT, i, TERMINATE_TAG, MPI_COMM_WORLD);
 
         // write logs to output file
-        writeLogs(OUTPUT_FILE, &searchLogs, numberOfPictures);
+        if (options.spoolDirectory == NULL)
+        {
+            stageStartTime = traceNow();
+            if (options.parallelOutput)
+                writeLogsParallel(outputFileName(options.resultFormat), NULL, NULL, NULL, 0, numberOfPictures, options.resultFormat);
+            else if (numberOfResultSets > 1)
+                for (int k = 0; k < numberOfResultSets; k++)
+                {
+                    char outputFile[MAX_THRESHOLD_FILE_NAME];
+                    Logs *thresholdLogs = searchLogs + k * numberOfPictures;
+                    thresholdOutputFileName(options.resultFormat, options.thresholds[k], outputFile);
+                    writeLogs(outputFile, &thresholdLogs, numberOfPictures, options.resultFormat);
+                }
+            else
+                writeLogs(outputFileName(options.resultFormat), &searchLogs, numberOfPictures, options.resultFormat);
+            traceRecord("write logs", stageStartTime, traceNow(), -1);
+        }
 
-        freeLogs(searchLogs, numberOfPictures);
         freePictures(pictures, numberOfPictures);
     }
     else
     {
+        ScoreMaps scoreMaps;
+        if (options.scoreMapDirectory != NULL && numberOfResultSets == 1)
+            openScoreMaps(&scoreMaps, options.scoreMapDirectory, objects, numberOfObjects);
+        // the orientations of the objects are built once and searched in every picture
+        OrientedObject *orientedObjects = options.orientations ? orientObjects(objects, numberOfObjects) : NULL;
+        MaskedObject *maskedObjects = options.maskObjects ? maskObjects(objects, numberOfObjects, options.transparentColor) : NULL;
+        // the ordered backend cuts the objects into blocks once, and orders the blocks again for every picture
+        int orderedBlocks = findMatchingBackend(options.backend)->function == calculateMatchingOrdered;
+        if (orderedBlocks)
+            for (int i = 0; i < numberOfObjects; i++)
+                computeVisitBlocks(&objects[i]);
+
+        // output records formatted by this process in parallel output mode, a service worker has no pictures here
+        int numberOfRecords = 0;
+        char **records = (char **)malloc((numberOfPictures + 1) * sizeof(char *));
+        checkMalloc(records, "output records array");
+        int *recordLengths = (int *)malloc((numberOfPictures + 1) * sizeof(int));
+        checkMalloc(recordLengths, "output record lengths array");
+        int *recordIndices = (int *)malloc((numberOfPictures + 1) * sizeof(int));
+        checkMalloc(recordIndices, "output record indices array");
+
+        stageStartTime = traceNow();
         MPI_Recv(&pictureIndex, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        traceRecord("wait for picture", stageStartTime, traceNow(), -1);
 
         // while master process does not send terminate signal
         while (status.MPI_TAG != TERMINATE_TAG)
         {
-            pictures = (Picture *)malloc(sizeof(Picture));
-            // receive first pictures from master process
-            receivePicture(pictures, 0, MPI_ANY_TAG, &status);
-
-            // allocate memory for the log
-            searchLogs = (Logs *)malloc(sizeof(Logs));
-            checkMalloc(searchLogs, "search logs array");
-            searchLogs->pictureID = pictures->ID;
-            searchLogs->numObjectsFound = 0;
-            searchLogs->objectIDs = (int *)malloc(numberOfObjects * sizeof(int));
-            checkMalloc(searchLogs->objectIDs, "object IDs array");
-            searchLogs->objectPositions = (Position *)malloc(numberOfObjects * sizeof(Position));
-            checkMalloc(searchLogs->objectPositions, "object positions array");
-
-            // initialize log positions to -1
-            #pragma omp parallel for
-            for (int i = 0; i < numberOfObjects; i++)
+            // a picture of the final phase is split into one strip per thread for every object, the other ranks may be idle
+            int numberOfStrips = status.MPI_TAG == LAST_PICTURE_TAG ? (options.numThreads > 0 ? options.numThreads : numberOfObjects) : 1;
+            int isBatch = status.MPI_TAG == BATCH_TAG;
+            int numberOfBatchPictures = 1;
+            int *pictureIndices = &pictureIndex;
+            // the pictures and logs of the previous round are released, the arena keeps the memory of the largest one
+            resetArena(&arena);
+            // receive the picture, or the batch of pictures whose size the master sent instead of an index
+            stageStartTime = traceNow();
+            if (isBatch)
+                numberOfBatchPictures = receivePictureBatch(&pictures, &pictureIndices, 0, BATCH_TAG, &status, &arena);
+            else
             {
-                searchLogs->objectPositions[i].row = NOT_FOUND;
-                searchLogs->objectPositions[i].column = NOT_FOUND;
+                pictures = (Picture *)arenaAllocate(&arena, sizeof(Picture));
+                receivePicture(pictures, 0, MPI_ANY_TAG, &status, &arena);
             }
+            traceRecord("receive picture", stageStartTime, traceNow(), pictures->ID);
+
+            // allocate memory for the logs, one per picture and threshold
+            searchLogs = (Logs *)arenaAllocate(&arena, numberOfBatchPictures * numberOfResultSets * sizeof(Logs));
+            for (int p = 0; p < numberOfBatchPictures; p++)
+            {
+                Logs *pictureLogs = searchLogs + p * numberOfResultSets;
+                for (int k = 0; k < numberOfResultSets; k++)
+                {
+                    pictureLogs[k].pictureID = pictures[p].ID;
+                    pictureLogs[k].numObjectsFound = 0;
+                    allocateLogArrays(&pictureLogs[k], numberOfObjects, &arena);
+
+                    // initialize log positions to -1
+                    #pragma omp parallel for
+                    for (int i = 0; i < numberOfObjects; i++)
+                    {
+                        pictureLogs[k].objectPositions[i].row = NOT_FOUND;
+                        pictureLogs[k].objectPositions[i].column = NOT_FOUND;
+                    }
+                }
 
-            // search for objects
-            findObjectsInPicture(pictures, objects, searchLogs, numberOfObjects, matchingThreshold);
+                // search for objects
+                stageStartTime = traceNow();
+                if (numberOfResultSets > 1)
+                    findObjectsAtThresholds(&pictures[p], objects, pictureLogs, numberOfObjects, options.thresholds, numberOfResultSets, options.numThreads);
+                else if (options.maskObjects)
+                    findMaskedObjects(&pictures[p], maskedObjects, pictureLogs, numberOfObjects, matchingThreshold, options.numThreads);
+                else if (options.orientations)
+                    findObjectsInOrientations(&pictures[p], orientedObjects, pictureLogs, numberOfObjects, matchingThreshold, options.numThreads);
+                else if (options.scoreMapDirectory != NULL)
+                    findObjectsWithScoreMap(&scoreMaps, &pictures[p], objects, pictureLogs, numberOfObjects, matchingThreshold, options.numThreads);
+                else
+                {
+                    if (orderedBlocks)
+                        orderVisitBlocks(&pictures[p], objects, numberOfObjects);
+                    findObjectsInPicture(&pictures[p], objects, pictureLogs, numberOfObjects, matchingThreshold, findMatchingBackend(options.backend)->function, options.numThreads, numberOfStrips);
+                }
+                traceRecord("search picture", stageStartTime, traceNow(), pictures[p].ID);
 
-            // send logs to master process
-            sendLog(searchLogs, 0, LOGS_TAG);
+                if (options.parallelOutput)
+                {
+                    // format the output record here, the master process is only notified
+                    records[numberOfRecords] = (char *)malloc(maxLogRecordLength(pictureLogs, options.resultFormat) + 1);
+                    checkMalloc(records[numberOfRecords], "output record");
+                    recordLengths[numberOfRecords] = formatLog(pictureLogs, options.resultFormat, records[numberOfRecords]);
+                    recordIndices[numberOfRecords] = pictureIndices[p];
+                    numberOfRecords++;
+                }
+            }
+
+            stageStartTime = traceNow();
+            if (options.parallelOutput)
+                MPI_Send(&pictureIndices[0], 1, MPI_INT, 0, LOGS_TAG, MPI_COMM_WORLD);
+            else if (isBatch)
+                // send the logs of the whole batch in one message
+                sendLogBatch(searchLogs, numberOfBatchPictures * numberOfResultSets, 0, LOGS_TAG);
+            else
+                // send logs to master process
+                for (int k = 0; k < numberOfResultSets; k++)
+                    sendLog(&searchLogs[k], 0, LOGS_TAG);
+            traceRecord("send log", stageStartTime, traceNow(), pictures->ID);
 
+            stageStartTime = traceNow();
             MPI_Recv(&pictureIndex, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-            freeLogs(searchLogs, 1);
-            freePictures(pictures, 1);
+            traceRecord("wait for picture", stageStartTime, traceNow(), -1);
+        }
+
+        if (options.parallelOutput)
+        {
+            stageStartTime = traceNow();
+            writeLogsParallel(outputFileName(options.resultFormat), records, recordLengths, recordIndices, numberOfRecords, numberOfPictures, options.resultFormat);
+            traceRecord("write logs", stageStartTime, traceNow(), -1);
         }
+
+        for (int i = 0; i < numberOfRecords; i++)
+            free(records[i]);
+        free(records);
+        free(recordLengths);
+        free(recordIndices);
+        if (orientedObjects != NULL)
+            freeOrientedObjects(orientedObjects, numberOfObjects);
+        if (maskedObjects != NULL)
+            freeMaskedObjects(maskedObjects, numberOfObjects);
     }
 
-    freeObjects(objects, numberOfObjects);
+    if (options.numa)
+        reportPlacement(objects, numberOfObjects, &arena, options.numThreads > 0 ? options.numThreads : numberOfObjects, rank, size);
+    freeArena(&arena);
+    if (options.objectSnapshot != NULL)
+        freeObjectSnapshot(&objectSnapshot);
+    else
+        freeObjects(objects, numberOfObjects);
 
     double endTime = MPI_Wtime();
     if (rank == 0)
         printf("Time taken: %f \n", endTime - startTime);
 
+    if (options.trace)
+        traceExport(TRACE_FILE, rank, size);
+
     MPI_Finalize();
     return 0;
 }
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+#include "maskHelper.h"
+#include "trace.h"
+
+void maskObject(Object *object, int transparentColor, MaskedObject *masked)
+{
+    masked->ID = object->ID;
+    masked->width = object->width;
+    masked->height = object->height;
+    masked->numberOfRuns = 0;
+    masked->numberOfActive = 0;
+
+    // a row has at most (width + 1) / 2 runs
+    masked->runs = (ObjectRun *)malloc(((size_t)object->height * ((object->width + 1) / 2) + 1) * sizeof(ObjectRun));
+    checkMalloc(masked->runs, "object runs array");
+    masked->colors = (int *)malloc(((size_t)object->width * object->height + 1) * sizeof(int));
+    checkMalloc(masked->colors, "active colors array");
+
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int objectColor = object->subColorsMatrix[i * object->pitch + j];
+            if (objectColor == transparentColor)
+                continue;
+            // a member right after the end of the last run extends it
+            ObjectRun *run = masked->numberOfRuns > 0 ? &masked->runs[masked->numberOfRuns - 1] : NULL;
+            if (run == NULL || run->row != i || run->column + run->length != j)
+            {
+                run = &masked->runs[masked->numberOfRuns++];
+                run->row = i;
+                run->column = j;
+                run->length = 0;
+                run->firstColor = masked->numberOfActive;
+            }
+            run->length++;
+            masked->colors[masked->numberOfActive++] = objectColor;
+        }
+}
+
+MaskedObject *maskObjects(Object *objects, int numberOfObjects, int transparentColor)
+{
+    MaskedObject *maskedObjects = (MaskedObject *)malloc(numberOfObjects * sizeof(MaskedObject));
+    checkMalloc(maskedObjects, "masked objects array");
+    for (int i = 0; i < numberOfObjects; i++)
+        maskObject(&objects[i], transparentColor, &maskedObjects[i]);
+    return maskedObjects;
+}
+
+void freeMaskedObjects(MaskedObject *maskedObjects, int numberOfObjects)
+{
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        free(maskedObjects[i].runs);
+        free(maskedObjects[i].colors);
+    }
+    free(maskedObjects);
+}
+
+/*
+ * The partial sum res plus abs((P - O) / P) of the active members of a run placed at a position, added one by one,
+ * so an object without transparent members is summed in the order of calculateMatchingOnCPU
+ */
+static inline double addRunValue(Picture *picture, MaskedObject *object, ObjectRun *run, int pictureRow, int pictureCol, double res)
+{
+    const int *objectColors = object->colors + run->firstColor;
+    const int *pictureRowColors = picture->colorsMatrix + (size_t)(pictureRow + run->row) * picture->pitch + pictureCol + run->column;
+    for (int j = 0; j < run->length; j++)
+        if (pictureRowColors[j] != 0)
+            res += (double)abs(pictureRowColors[j] - objectColors[j]) / pictureRowColors[j];
+    return res;
+}
+
+double calculateMaskedScore(Picture *picture, MaskedObject *object, int row, int column)
+{
+    double res = 0;
+    for (int r = 0; r < object->numberOfRuns; r++)
+        res = addRunValue(picture, object, &object->runs[r], row, column, res);
+    return res / object->numberOfActive;
+}
+
+void calculateMatchingMasked(Picture *picture, MaskedObject *object, int *upperLeftCorner, double matchingThreshold)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    double activeCount = object->numberOfActive;
+    if (object->numberOfActive == 0)
+        return;
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+        {
+            double res = 0;
+            int r;
+            for (r = 0; r < object->numberOfRuns; r++)
+            {
+                res = addRunValue(picture, object, &object->runs[r], pictureRow, pictureCol, res);
+                // the partial sums only grow, so a position whose partial value reached the threshold cannot match
+                if (res / activeCount >= matchingThreshold)
+                    break;
+            }
+            if (r == object->numberOfRuns)
+            {
+                *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                return;
+            }
+        }
+}
+
+void findMaskedObjects(Picture *picture, MaskedObject *maskedObjects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads)
+{
+    double searchStartTime = omp_get_wtime();
+    int *upperLeftCorners = (int *)malloc(numberOfObjects * sizeof(int));
+    checkMalloc(upperLeftCorners, "upper left corners array");
+    double *objectTimes = (double *)malloc(numberOfObjects * sizeof(double));
+    checkMalloc(objectTimes, "object times array");
+
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads > 0 ? numThreads : numberOfObjects)
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        double objectStartTime = omp_get_wtime();
+        double traceStartTime = traceNow();
+        upperLeftCorners[i] = NOT_FOUND;
+        calculateMatchingMasked(picture, &maskedObjects[i], &upperLeftCorners[i], matchingThreshold);
+        traceRecord("search object", traceStartTime, traceNow(), maskedObjects[i].ID);
+        objectTimes[i] = omp_get_wtime() - objectStartTime;
+    }
+
+    log->pictureID = picture->ID;
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        if (upperLeftCorners[i] == NOT_FOUND)
+            continue;
+        int row = upperLeftCorners[i] / picture->width;
+        int column = upperLeftCorners[i] % picture->width;
+        log->objectIDs[log->numObjectsFound] = maskedObjects[i].ID;
+        log->objectPositions[log->numObjectsFound].row = row;
+        log->objectPositions[log->numObjectsFound].column = column;
+        log->objectScores[log->numObjectsFound] = calculateMaskedScore(picture, &maskedObjects[i], row, column);
+        log->objectTimes[log->numObjectsFound] = objectTimes[i];
+        log->objectOrientations[log->numObjectsFound] = 0;
+        log->numObjectsFound++;
+    }
+    free(upperLeftCorners);
+    free(objectTimes);
+
+    log->searchTime = omp_get_wtime() - searchStartTime;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "helper.h"
+
+/*
+ * A run of consecutive active members in a row of an object
+ */
+struct ObjectRunStruct
+{
+    int row;
+    int column;
+    int length;
+    int firstColor; // the index of the color of the first member in the active colors
+};
+typedef struct ObjectRunStruct ObjectRun;
+
+/*
+ * An object without its transparent members. Only the active members are compared with the picture,
+ * and the matching value is averaged over them instead of over the whole width * height.
+ */
+struct MaskedObjectStruct
+{
+    int ID;
+    int width;
+    int height;
+    int numberOfRuns;
+    ObjectRun *runs; // row by row, left to right
+    int numberOfActive;
+    int *colors; // the colors of the active members, row by row
+};
+typedef struct MaskedObjectStruct MaskedObject;
+
+/*
+ * This function compacts an object into the runs of its members that do not have the transparent color
+ * @param object: pointer to the object
+ * @param transparentColor: the color of the members to skip
+ * @param masked: the masked object
+ * @return: void
+ */
+void maskObject(Object *object, int transparentColor, MaskedObject *masked);
+
+/*
+ * This function compacts every object
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param transparentColor: the color of the members to skip
+ * @return: the array of masked objects
+ */
+MaskedObject *maskObjects(Object *objects, int numberOfObjects, int transparentColor);
+
+/*
+ * This function frees the masked objects
+ * @param maskedObjects: the array of masked objects
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void freeMaskedObjects(MaskedObject *maskedObjects, int numberOfObjects);
+
+/*
+ * This function calculates the matching score of a masked object at a position of a picture
+ * @param picture: pointer to the picture
+ * @param object: pointer to the masked object
+ * @param row: the upper left corner row of the object in the picture
+ * @param column: the upper left corner column of the object in the picture
+ * @return: the matching score, the average of abs((P - O) / P) over the active members
+ */
+double calculateMaskedScore(Picture *picture, MaskedObject *object, int row, int column);
+
+/*
+ * This function searches a masked object in a picture, visiting only the active members of every position.
+ * A position is left as soon as its partial value reaches the threshold, like calculateMatchingPruned.
+ * An object without active members matches nowhere.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the masked object
+ * @param upperLeftCorner: the index of the upper left corner of the first match, left unchanged if there is none
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingMasked(Picture *picture, MaskedObject *object, int *upperLeftCorner, double matchingThreshold);
+
+/*
+ * This function finds the masked objects in a picture and fills the log with the first match of every object
+ * @param picture: pointer to the picture
+ * @param maskedObjects: the array of masked objects
+ * @param log: the log, with arrays for numberOfObjects objects
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold
+ * @param numThreads: the number of OpenMP threads, 0 for one thread per object
+ * @return: void
+ */
+void findMaskedObjects(Picture *picture, MaskedObject *maskedObjects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads);
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "numaHelper.h"
+#include "arenaHelper.h"
+
+static int numaPlacement = 0;
+
+void enableNumaPlacement(void)
+{
+    numaPlacement = 1;
+}
+
+int allocateAligned(void **memory, size_t alignment, size_t size)
+{
+    if (!numaPlacement || size < HUGE_PAGE_SIZE)
+        return posix_memalign(memory, alignment, size);
+
+    // a huge page needs a huge page aligned range, the kernel backs it on the first touch
+    size_t hugeSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    int error = posix_memalign(memory, alignment > HUGE_PAGE_SIZE ? alignment : HUGE_PAGE_SIZE, hugeSize);
+    if (error == 0)
+        madvise(*memory, hugeSize, MADV_HUGEPAGE);
+    return error;
+}
+
+void pinThreads(int numThreads)
+{
+    cpu_set_t allowed;
+    int cpus[CPU_SETSIZE];
+    int numberOfCpus = 0;
+
+    if (!numaPlacement || omp_get_proc_bind() != omp_proc_bind_false || sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, &allowed))
+            cpus[numberOfCpus++] = cpu;
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+        // thread t gets cpu t * cpus / threads, so the threads spread over the cores of the process
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpus[(long long)omp_get_thread_num() * numberOfCpus / omp_get_num_threads()], &pinned);
+        sched_setaffinity(0, sizeof(pinned), &pinned);
+    }
+}
+
+/*
+ * This function counts the pages of a buffer on every NUMA node, the last count holds the pages without a node
+ */
+static void countPageNodes(const void *buffer, size_t size, long long *pages)
+{
+    const char *start = (const char *)((unsigned long long)buffer / PLACEMENT_PAGE_SIZE * PLACEMENT_PAGE_SIZE);
+    const char *end = (const char *)buffer + size;
+    for (const char *page = start; page < end; page += PLACEMENT_PAGE_SIZE)
+    {
+        // move_pages without target nodes only reports the node of every page
+        void *address = (void *)page;
+        int node = -1;
+        if (syscall(SYS_move_pages, 0, 1, &address, NULL, &node, 0) != 0 || node < 0 || node >= MAX_NUMA_NODES)
+            node = MAX_NUMA_NODES;
+        pages[node]++;
+    }
+}
+
+static void printPageNodes(const char *name, long long *pages, size_t bytes)
+{
+    printf("  %s: %.1f KB,", name, bytes / 1024.0);
+    for (int node = 0; node <= MAX_NUMA_NODES; node++)
+        if (pages[node] > 0)
+        {
+            if (node < MAX_NUMA_NODES)
+                printf(" node %d: %lld pages", node, pages[node]);
+            else
+                printf(" not resident: %lld pages", pages[node]);
+        }
+    printf("%s \r \n", numaPlacement && bytes >= HUGE_PAGE_SIZE ? ", huge pages advised" : "");
+}
+
+void reportPlacement(Object *objects, int numberOfObjects, Arena *arena, int numThreads, int rank, int size)
+{
+    for (int turn = 0; turn < size; turn++)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        if (turn != rank)
+            continue;
+
+        cpu_set_t allowed;
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        printf("Rank %d: %d allowed cpus, %s \r \n", rank, CPU_COUNT(&allowed),
+               omp_get_proc_bind() != omp_proc_bind_false ? "threads placed by OMP_PROC_BIND" : numaPlacement ? "threads pinned" : "threads not pinned");
+
+        // the team of the search, every thread reports where it runs
+        #pragma omp parallel num_threads(numThreads)
+        {
+            unsigned int cpu = 0, node = 0;
+            syscall(SYS_getcpu, &cpu, &node, NULL);
+            #pragma omp critical
+            printf("  thread %d: cpu %u, node %u \r \n", omp_get_thread_num(), cpu, node);
+        }
+
+        long long pages[MAX_NUMA_NODES + 1];
+        size_t bytes = 0;
+        memset(pages, 0, sizeof(pages));
+        for (int i = 0; i < numberOfObjects; i++)
+        {
+            size_t objectBytes = (size_t)objects[i].pitch * objects[i].height * sizeof(int);
+            countPageNodes(objects[i].subColorsMatrix, objectBytes, pages);
+            bytes += objectBytes;
+        }
+        printPageNodes("objects", pages, bytes);
+
+        bytes = 0;
+        memset(pages, 0, sizeof(pages));
+        for (ArenaBlock *block = arena->blocks; block != NULL; block = block->next)
+        {
+            countPageNodes(block, block->size, pages);
+            bytes += block->size;
+        }
+        printPageNodes(rank == 0 ? "logs" : "picture and logs", pages, bytes);
+        fflush(stdout);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "helper.h"
+
+#define HUGE_PAGE_SIZE (2 << 20)
+#define PLACEMENT_PAGE_SIZE 4096
+#define MAX_NUMA_NODES 64
+
+/*
+ * NUMA placement is meant for one process per NUMA node (mpiexec --map-by numa --bind-to numa). Every process
+ * already holds its own copy of the objects, so each node gets a replica. Its threads are pinned to the CPUs of
+ * the process, and the main thread that receives the pictures touches them first, so they land on the same node.
+ */
+
+/*
+ * This function enables huge pages for large allocations and the pinning of the OpenMP threads
+ * @return: void
+ */
+void enableNumaPlacement(void);
+
+/*
+ * This function allocates aligned memory like posix_memalign. With NUMA placement, allocations of at least
+ * HUGE_PAGE_SIZE bytes are aligned to HUGE_PAGE_SIZE and advised to use transparent huge pages.
+ * @param memory: the allocated memory, NULL on failure
+ * @param alignment: the alignment in bytes, a power of 2
+ * @param size: the size in bytes
+ * @return: 0 on success, an error number otherwise
+ */
+int allocateAligned(void **memory, size_t alignment, size_t size);
+
+/*
+ * This function pins the threads of an OpenMP team to the CPUs the process may run on, spread evenly over them.
+ * The runtime keeps the threads of a team for later teams of the same size, so they stay pinned.
+ * Nothing is changed when the placement is already set with OMP_PROC_BIND or OMP_PLACES.
+ * @param numThreads: the number of threads of the team
+ * @return: void
+ */
+void pinThreads(int numThreads);
+
+/*
+ * This function writes where the threads and buffers of every process landed to stdout, one process after
+ * the other. It has to be called by every process.
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param arena: the arena of the pictures and logs
+ * @param numThreads: the number of threads searching a picture
+ * @param rank: the rank of the process
+ * @param size: the number of processes
+ * @return: void
+ */
+void reportPlacement(Object *objects, int numberOfObjects, Arena *arena, int numThreads, int rank, int size);
@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <omp.h>
+#include "orientationHelper.h"
+#include "trace.h"
+
+void orientObject(Object *object, int orientation, Object *oriented)
+{
+    int rotations = orientation % 4;
+    int isMirrored = orientation >= 4;
+
+    if (rotations % 2 == 0)
+        allocateObject(oriented, object->width, object->height);
+    else
+        allocateObject(oriented, object->height, object->width);
+    oriented->ID = object->ID;
+
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            // mirror the member, then turn it clockwise a quarter at a time, (row, column) goes to (column, height - 1 - row)
+            int row = i, column = isMirrored ? object->width - 1 - j : j;
+            int height = object->height, width = object->width;
+            for (int r = 0; r < rotations; r++)
+            {
+                int turnedRow = column;
+                column = height - 1 - row;
+                row = turnedRow;
+                int turnedHeight = width;
+                width = height;
+                height = turnedHeight;
+            }
+            oriented->subColorsMatrix[row * oriented->pitch + column] = object->subColorsMatrix[i * object->pitch + j];
+        }
+}
+
+/*
+ * Whether two objects have the same shape and colors
+ */
+static int sameObject(Object *first, Object *second)
+{
+    if (first->width != second->width || first->height != second->height)
+        return 0;
+    for (int i = 0; i < first->height; i++)
+        if (memcmp(first->subColorsMatrix + i * first->pitch, second->subColorsMatrix + i * second->pitch, first->width * sizeof(int)) != 0)
+            return 0;
+    return 1;
+}
+
+OrientedObject *orientObjects(Object *objects, int numberOfObjects)
+{
+    OrientedObject *orientedObjects = (OrientedObject *)malloc(numberOfObjects * sizeof(OrientedObject));
+    checkMalloc(orientedObjects, "oriented objects array");
+
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        OrientedObject *oriented = &orientedObjects[i];
+        oriented->numberOfVariants = 0;
+        for (int o = 0; o < NUMBER_OF_ORIENTATIONS; o++)
+        {
+            Object *variant = &oriented->variants[oriented->numberOfVariants];
+            orientObject(&objects[i], o, variant);
+            int isDuplicate = 0;
+            for (int k = 0; k < oriented->numberOfVariants && !isDuplicate; k++)
+                isDuplicate = sameObject(&oriented->variants[k], variant);
+            if (isDuplicate)
+            {
+                free(variant->subColorsMatrix);
+                continue;
+            }
+            oriented->orientations[oriented->numberOfVariants++] = o;
+        }
+    }
+    return orientedObjects;
+}
+
+void freeOrientedObjects(OrientedObject *orientedObjects, int numberOfObjects)
+{
+    for (int i = 0; i < numberOfObjects; i++)
+        for (int k = 0; k < orientedObjects[i].numberOfVariants; k++)
+            free(orientedObjects[i].variants[k].subColorsMatrix);
+    free(orientedObjects);
+}
+
+int pictureReciprocals(Picture *picture, double *reciprocals)
+{
+    int hasNegativeColors = 0;
+    for (size_t m = 0; m < (size_t)picture->pitch * picture->height; m++)
+    {
+        int pictureColor = picture->colorsMatrix[m];
+        reciprocals[m] = pictureColor != 0 ? 1.0 / pictureColor : 0;
+        hasNegativeColors |= pictureColor < 0;
+    }
+    return !hasNegativeColors;
+}
+
+/*
+ * This function sums the variants of one shape at a position row by row, every picture color and its reciprocal
+ * are loaded once for all of them. A variant is dropped once its partial sum reaches the limit, and the
+ * variants left at the end are marked as candidates.
+ * @return: the number of candidates
+ */
+static int sumVariants(Picture *picture, const double *reciprocals, Object *variants, const int *shapeVariants, int numberOfShapeVariants,
+                       int pictureRow, int pictureCol, double limit, int *isCandidate)
+{
+    Object *shape = &variants[shapeVariants[0]];
+    int alive[NUMBER_OF_ORIENTATIONS];
+    double sums[NUMBER_OF_ORIENTATIONS];
+    int numberOfAlive = numberOfShapeVariants;
+    for (int a = 0; a < numberOfAlive; a++)
+    {
+        alive[a] = shapeVariants[a];
+        sums[a] = 0;
+    }
+
+    for (int i = 0; i < shape->height && numberOfAlive > 0; i++)
+    {
+        const int *pictureRowColors = picture->colorsMatrix + (size_t)(pictureRow + i) * picture->pitch + pictureCol;
+        const double *reciprocalRow = reciprocals + (size_t)(pictureRow + i) * picture->pitch + pictureCol;
+        const int *objectRows[NUMBER_OF_ORIENTATIONS];
+        double rowSums[NUMBER_OF_ORIENTATIONS];
+        for (int a = 0; a < numberOfAlive; a++)
+        {
+            objectRows[a] = variants[alive[a]].subColorsMatrix + i * shape->pitch;
+            rowSums[a] = 0;
+        }
+        for (int j = 0; j < shape->width; j++)
+        {
+            int pictureColor = pictureRowColors[j];
+            double reciprocal = reciprocalRow[j];
+            for (int a = 0; a < numberOfAlive; a++)
+                rowSums[a] += abs(pictureColor - objectRows[a][j]) * reciprocal;
+        }
+
+        // the partial sums only grow, so a variant whose partial sum reached the limit cannot match
+        int kept = 0;
+        for (int a = 0; a < numberOfAlive; a++)
+            if (sums[a] + rowSums[a] < limit)
+            {
+                alive[kept] = alive[a];
+                sums[kept] = sums[a] + rowSums[a];
+                kept++;
+            }
+        numberOfAlive = kept;
+    }
+
+    for (int a = 0; a < numberOfAlive; a++)
+        isCandidate[alive[a]] = 1;
+    return numberOfAlive;
+}
+
+void calculateMatchingOrientations(Picture *picture, const double *reciprocals, OrientedObject *object, int *upperLeftCorner, int *orientation, double matchingThreshold)
+{
+    Object *variants = object->variants;
+    double area = variants[0].width * variants[0].height;
+    // a sum by reciprocals is within (area + 2) * DBL_EPSILON of the sum by divisions relative to its size,
+    // the limit is wider, so a variant below the threshold always stays a candidate
+    double limit = reciprocals != NULL ? matchingThreshold * area * (1 + ORIENTATION_ERROR_FACTOR * (area + 4) * DBL_EPSILON) : INFINITY;
+
+    // an object has at most two shapes, its own and the one turned a quarter
+    int shapeVariants[2][NUMBER_OF_ORIENTATIONS], numberOfShapeVariants[2] = {0, 0};
+    int lastRow = -1, lastColumn = -1;
+    for (int k = 0; k < object->numberOfVariants; k++)
+    {
+        int shape = variants[k].width == variants[0].width && variants[k].height == variants[0].height ? 0 : 1;
+        shapeVariants[shape][numberOfShapeVariants[shape]++] = k;
+        lastRow = picture->height - variants[k].height > lastRow ? picture->height - variants[k].height : lastRow;
+        lastColumn = picture->width - variants[k].width > lastColumn ? picture->width - variants[k].width : lastColumn;
+    }
+
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+        {
+            int isCandidate[NUMBER_OF_ORIENTATIONS] = {0};
+            int numberOfCandidates = 0;
+            for (int shape = 0; shape < 2; shape++)
+            {
+                if (numberOfShapeVariants[shape] == 0)
+                    continue;
+                Object *shapeObject = &variants[shapeVariants[shape][0]];
+                if (pictureRow > picture->height - shapeObject->height || pictureCol > picture->width - shapeObject->width)
+                    continue;
+                if (reciprocals == NULL)
+                {
+                    for (int a = 0; a < numberOfShapeVariants[shape]; a++)
+                        isCandidate[shapeVariants[shape][a]] = 1;
+                    numberOfCandidates += numberOfShapeVariants[shape];
+                }
+                else
+                    numberOfCandidates += sumVariants(picture, reciprocals, variants, shapeVariants[shape], numberOfShapeVariants[shape],
+                                                      pictureRow, pictureCol, limit, isCandidate);
+            }
+            if (numberOfCandidates == 0)
+                continue;
+
+            // the candidates are evaluated like calculateMatchingOnCPU, the lowest matching orientation wins
+            for (int k = 0; k < object->numberOfVariants; k++)
+                if (isCandidate[k] && calculateMatchingScore(picture, &variants[k], pictureRow, pictureCol) < matchingThreshold)
+                {
+                    *upperLeftCorner = pictureRow * picture->width + pictureCol;
+                    *orientation = object->orientations[k];
+                    return;
+                }
+        }
+}
+
+void findObjectsInOrientations(Picture *picture, OrientedObject *orientedObjects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads)
+{
+    double searchStartTime = omp_get_wtime();
+
+    // the reciprocals are computed once per picture and shared by all objects
+    double *reciprocals = (double *)malloc(((size_t)picture->pitch * picture->height + 1) * sizeof(double));
+    checkMalloc(reciprocals, "picture reciprocals");
+    int hasReciprocals = pictureReciprocals(picture, reciprocals);
+    int *upperLeftCorners = (int *)malloc(numberOfObjects * sizeof(int));
+    checkMalloc(upperLeftCorners, "upper left corners array");
+    int *orientations = (int *)malloc(numberOfObjects * sizeof(int));
+    checkMalloc(orientations, "orientations array");
+    double *objectTimes = (double *)malloc(numberOfObjects * sizeof(double));
+    checkMalloc(objectTimes, "object times array");
+
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads > 0 ? numThreads : numberOfObjects)
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        double objectStartTime = omp_get_wtime();
+        double traceStartTime = traceNow();
+        upperLeftCorners[i] = NOT_FOUND;
+        calculateMatchingOrientations(picture, hasReciprocals ? reciprocals : NULL, &orientedObjects[i], &upperLeftCorners[i], &orientations[i], matchingThreshold);
+        traceRecord("search object", traceStartTime, traceNow(), orientedObjects[i].variants[0].ID);
+        objectTimes[i] = omp_get_wtime() - objectStartTime;
+    }
+
+    log->pictureID = picture->ID;
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        if (upperLeftCorners[i] == NOT_FOUND)
+            continue;
+        int row = upperLeftCorners[i] / picture->width;
+        int column = upperLeftCorners[i] % picture->width;
+        int k = 0;
+        while (orientedObjects[i].orientations[k] != orientations[i])
+            k++;
+        log->objectIDs[log->numObjectsFound] = orientedObjects[i].variants[k].ID;
+        log->objectPositions[log->numObjectsFound].row = row;
+        log->objectPositions[log->numObjectsFound].column = column;
+        log->objectScores[log->numObjectsFound] = calculateMatchingScore(picture, &orientedObjects[i].variants[k], row, column);
+        log->objectTimes[log->numObjectsFound] = objectTimes[i];
+        log->objectOrientations[log->numObjectsFound] = orientations[i];
+        log->numObjectsFound++;
+    }
+    free(reciprocals);
+    free(upperLeftCorners);
+    free(orientations);
+    free(objectTimes);
+
+    log->searchTime = omp_get_wtime() - searchStartTime;
+}
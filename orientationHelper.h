@@ -0,0 +1,80 @@
+#pragma once
+#include "helper.h"
+
+#define NUMBER_OF_ORIENTATIONS 8
+#define ORIENTATION_ERROR_FACTOR 4
+
+/*
+ * The distinct orientations of an object. Orientations equal to a lower one, like the rotations of a symmetric
+ * object, are left out, since the lower orientation always matches first.
+ */
+struct OrientedObjectStruct
+{
+    int numberOfVariants;
+    int orientations[NUMBER_OF_ORIENTATIONS]; // the orientation of every variant, increasing
+    Object variants[NUMBER_OF_ORIENTATIONS];
+};
+typedef struct OrientedObjectStruct OrientedObject;
+
+/*
+ * This function builds an orientation of an object. Orientation o mirrors the object left to right when o >= 4
+ * and then rotates it clockwise by (o % 4) * 90 degrees, so 0 is the object itself.
+ * @param object: pointer to the object
+ * @param orientation: the orientation, 0 to NUMBER_OF_ORIENTATIONS - 1
+ * @param oriented: the oriented object, with the ID of the object and its own colors matrix
+ * @return: void
+ */
+void orientObject(Object *object, int orientation, Object *oriented);
+
+/*
+ * This function builds the distinct orientations of every object
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: the array of oriented objects
+ */
+OrientedObject *orientObjects(Object *objects, int numberOfObjects);
+
+/*
+ * This function frees the oriented objects
+ * @param orientedObjects: the array of oriented objects
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void freeOrientedObjects(OrientedObject *orientedObjects, int numberOfObjects);
+
+/*
+ * This function computes 1 / P of every picture color, 0 for colors 0, with the pitch of the picture
+ * @param picture: pointer to the picture
+ * @param reciprocals: the reciprocals, pitch * height doubles
+ * @return: 1 if the picture has no negative colors, 0 otherwise
+ */
+int pictureReciprocals(Picture *picture, double *reciprocals);
+
+/*
+ * This function searches all orientations of an object in a picture in one pass. At every position the variants
+ * of the same shape are summed together, every picture color and its reciprocal are loaded once for all of them,
+ * and the position is left once every variant reached the threshold. The sums multiply by the reciprocals,
+ * so they are compared with the threshold widened by their rounding error, and the variants below it are
+ * evaluated again like calculateMatchingOnCPU. The decisions are the same as searching every variant on its own.
+ * @param picture: pointer to the picture
+ * @param reciprocals: the reciprocals of the picture (see pictureReciprocals), NULL if it has negative colors,
+ * then every variant that fits is evaluated directly
+ * @param object: pointer to the oriented object
+ * @param upperLeftCorner: the index of the upper left corner of the first match in row-major order, left unchanged if there is none
+ * @param orientation: the lowest orientation matching at that position
+ * @param matchingThreshold: the matching threshold
+ * @return: void
+ */
+void calculateMatchingOrientations(Picture *picture, const double *reciprocals, OrientedObject *object, int *upperLeftCorner, int *orientation, double matchingThreshold);
+
+/*
+ * This function finds all orientations of the objects in a picture and fills the log with the first match of every object
+ * @param picture: pointer to the picture
+ * @param orientedObjects: the array of oriented objects
+ * @param log: the log, with arrays for numberOfObjects objects
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold
+ * @param numThreads: the number of OpenMP threads, 0 for one thread per object
+ * @return: void
+ */
+void findObjectsInOrientations(Picture *picture, OrientedObject *orientedObjects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads);
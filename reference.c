@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include "reference.h"
+
+double referenceMatchingValue(Picture *picture, Object *object, int row, int column)
+{
+    double res = 0;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int objectColor = object->subColorsMatrix[i * object->pitch + j];
+            int pictureColor = picture->colorsMatrix[(row + i) * picture->pitch + (column + j)];
+            if (pictureColor != 0)
+                res += (double)abs(pictureColor - objectColor) / pictureColor;
+        }
+    return res / (object->width * object->height);
+}
+
+int referenceMatchesAt(Picture *picture, Object *object, int row, int column, double matchingThreshold)
+{
+    return referenceMatchingValue(picture, object, row, column) < matchingThreshold;
+}
+
+int referenceFirstMatch(Picture *picture, Object *object, double matchingThreshold)
+{
+    for (int row = 0; row + object->height <= picture->height; row++)
+        for (int column = 0; column + object->width <= picture->width; column++)
+            if (referenceMatchesAt(picture, object, row, column, matchingThreshold))
+                return row * picture->width + column;
+    return NOT_FOUND;
+}
+
+double referenceMaskedValue(Picture *picture, Object *object, int transparentColor, int row, int column)
+{
+    double res = 0;
+    int numberOfActive = 0;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int objectColor = object->subColorsMatrix[i * object->pitch + j];
+            int pictureColor = picture->colorsMatrix[(row + i) * picture->pitch + (column + j)];
+            if (objectColor == transparentColor)
+                continue;
+            numberOfActive++;
+            if (pictureColor != 0)
+                res += (double)abs(pictureColor - objectColor) / pictureColor;
+        }
+    return res / numberOfActive;
+}
+
+int referenceMaskedFirstMatch(Picture *picture, Object *object, int transparentColor, double matchingThreshold)
+{
+    int numberOfActive = 0;
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+            numberOfActive += object->subColorsMatrix[i * object->pitch + j] != transparentColor;
+    if (numberOfActive == 0)
+        return NOT_FOUND;
+
+    for (int row = 0; row + object->height <= picture->height; row++)
+        for (int column = 0; column + object->width <= picture->width; column++)
+            if (referenceMaskedValue(picture, object, transparentColor, row, column) < matchingThreshold)
+                return row * picture->width + column;
+    return NOT_FOUND;
+}
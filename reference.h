@@ -0,0 +1,57 @@
+#pragma once
+#include "helper.h"
+
+/*
+ * Plain reference implementation of the search, kept as simple as possible on purpose.
+ * Optimized backends are checked against it, so it must not be optimized itself.
+ */
+
+/*
+ * This function calculates the matching value of an object at a position of a picture:
+ * the sum of abs((P - O) / P) over the overlapping members whose picture color is not 0, divided by the object area
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param row: the upper left corner row of the object in the picture
+ * @param column: the upper left corner column of the object in the picture
+ * @return: the matching value
+ */
+double referenceMatchingValue(Picture *picture, Object *object, int row, int column);
+
+/*
+ * This function decides whether an object matches a picture at a position, the value must be strictly below the threshold
+ * @return: 1 if the position matches, 0 otherwise
+ */
+int referenceMatchesAt(Picture *picture, Object *object, int row, int column, double matchingThreshold);
+
+/*
+ * This function finds the first matching position in row-major order
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param matchingThreshold: the matching threshold
+ * @return: the index row * picture width + column of the first match, or NOT_FOUND
+ */
+int referenceFirstMatch(Picture *picture, Object *object, double matchingThreshold);
+
+/*
+ * This function calculates the matching value of an object with transparent members at a position of a picture:
+ * the sum of abs((P - O) / P) over the members without the transparent color whose picture color is not 0,
+ * divided by the number of members without the transparent color
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param transparentColor: the color of the members to skip
+ * @param row: the upper left corner row of the object in the picture
+ * @param column: the upper left corner column of the object in the picture
+ * @return: the matching value
+ */
+double referenceMaskedValue(Picture *picture, Object *object, int transparentColor, int row, int column);
+
+/*
+ * This function finds the first matching position of an object with transparent members in row-major order,
+ * an object whose members are all transparent matches nowhere
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param transparentColor: the color of the members to skip
+ * @param matchingThreshold: the matching threshold
+ * @return: the index row * picture width + column of the first match, or NOT_FOUND
+ */
+int referenceMaskedFirstMatch(Picture *picture, Object *object, int transparentColor, double matchingThreshold);
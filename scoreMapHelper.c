@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+#include <sys/stat.h>
+#include "scoreMapHelper.h"
+#include "trace.h"
+
+void openScoreMaps(ScoreMaps *scoreMaps, const char *directory, Object *objects, int numberOfObjects)
+{
+    scoreMaps->directory = directory;
+    initializeKey(&scoreMaps->objectsKey);
+    hashObjectSet(&scoreMaps->objectsKey, objects, numberOfObjects);
+    mkdir(directory, 0755);
+}
+
+static void scoreMapFileName(ScoreMaps *scoreMaps, Picture *picture, char *file)
+{
+    CacheKey key = scoreMaps->objectsKey;
+    hashPicture(&key, picture);
+    snprintf(file, MAX_SCORE_MAP_PATH, "%s/%016llx%016llx%s", scoreMaps->directory, key.words[0], key.words[1], SCORE_MAP_EXTENSION);
+}
+
+ScoreRecord *calculateRecordLows(Picture *picture, Object *object, int *numberOfRecords)
+{
+    int lastRow = picture->height - object->height;
+    int lastColumn = picture->width - object->width;
+    double area = object->width * object->height;
+    double lowest = INFINITY;
+    int capacity = 16;
+
+    ScoreRecord *records = (ScoreRecord *)malloc(capacity * sizeof(ScoreRecord));
+    checkMalloc(records, "record lows");
+    *numberOfRecords = 0;
+    for (int pictureRow = 0; pictureRow <= lastRow; pictureRow++)
+        for (int pictureCol = 0; pictureCol <= lastColumn; pictureCol++)
+        {
+            double res = 0;
+            int i;
+            for (i = 0; i < object->height; i++)
+            {
+                int *objectRow = object->subColorsMatrix + i * object->pitch;
+                int *pictureRowColors = picture->colorsMatrix + (pictureRow + i) * picture->pitch + pictureCol;
+                for (int j = 0; j < object->width; j++)
+                    if (pictureRowColors[j] != 0)
+                        res += (double)abs(pictureRowColors[j] - objectRow[j]) / pictureRowColors[j];
+                // the partial sums only grow, so a partial value at the lowest value cannot give a record low
+                if (res / area >= lowest)
+                    break;
+            }
+            if (i < object->height)
+                continue;
+
+            // the complete sum is in the order of calculateMatchingOnCPU, so the record value is the exact value
+            lowest = res / area;
+            if (*numberOfRecords == capacity)
+            {
+                capacity *= 2;
+                records = (ScoreRecord *)realloc(records, capacity * sizeof(ScoreRecord));
+                checkMalloc(records, "record lows");
+            }
+            records[*numberOfRecords].position = pictureRow * picture->width + pictureCol;
+            records[*numberOfRecords].reserved = 0;
+            records[*numberOfRecords].score = lowest;
+            (*numberOfRecords)++;
+        }
+    return records;
+}
+
+int findFirstRecordBelow(ScoreRecord *records, int numberOfRecords, double matchingThreshold)
+{
+    for (int r = 0; r < numberOfRecords; r++)
+        if (records[r].score < matchingThreshold)
+            return r;
+    return NOT_FOUND;
+}
+
+/*
+ * This function adds an object to a log when one of its record lows is below the threshold
+ */
+static void addFirstMatch(Logs *log, Picture *picture, int objectID, ScoreRecord *records, int numberOfRecords, double matchingThreshold, double objectTime)
+{
+    int r = findFirstRecordBelow(records, numberOfRecords, matchingThreshold);
+    if (r == NOT_FOUND)
+        return;
+    log->objectIDs[log->numObjectsFound] = objectID;
+    log->objectPositions[log->numObjectsFound].row = records[r].position / picture->width;
+    log->objectPositions[log->numObjectsFound].column = records[r].position % picture->width;
+    log->objectScores[log->numObjectsFound] = records[r].score;
+    log->objectTimes[log->numObjectsFound] = objectTime;
+    log->objectOrientations[log->numObjectsFound] = 0;
+    log->numObjectsFound++;
+}
+
+void findObjectsWithScoreMap(ScoreMaps *scoreMaps, Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads)
+{
+    double searchStartTime = omp_get_wtime();
+    ScoreRecord **records = (ScoreRecord **)malloc(numberOfObjects * sizeof(ScoreRecord *));
+    checkMalloc(records, "record lows array");
+    ScoreMapObjectRecord *objectRecords = (ScoreMapObjectRecord *)malloc(numberOfObjects * sizeof(ScoreMapObjectRecord));
+    checkMalloc(objectRecords, "score map object records");
+
+    #pragma omp parallel for schedule(dynamic) num_threads(numThreads > 0 ? numThreads : numberOfObjects)
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        double objectStartTime = omp_get_wtime();
+        double traceStartTime = traceNow();
+        records[i] = calculateRecordLows(picture, objects + i, &objectRecords[i].numberOfRecords);
+        traceRecord("search object", traceStartTime, traceNow(), objects[i].ID);
+        objectRecords[i].objectID = objects[i].ID;
+        objectRecords[i].scanTime = omp_get_wtime() - objectStartTime;
+    }
+
+    log->pictureID = picture->ID;
+    log->numObjectsFound = 0;
+    for (int i = 0; i < numberOfObjects; i++)
+        addFirstMatch(log, picture, objects[i].ID, records[i], objectRecords[i].numberOfRecords, matchingThreshold, objectRecords[i].scanTime);
+    log->searchTime = omp_get_wtime() - searchStartTime;
+
+    // the map is written to a temporary file and renamed, so a reader never sees a partial map
+    char file[MAX_SCORE_MAP_PATH], temporaryFile[MAX_SCORE_MAP_PATH + 16];
+    scoreMapFileName(scoreMaps, picture, file);
+    snprintf(temporaryFile, sizeof(temporaryFile), "%s.%d.tmp", file, picture->ID);
+    FILE *fp = fopen(temporaryFile, "wb");
+    if (fp != NULL)
+    {
+        ScoreMapFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SCORE_MAP_MAGIC, sizeof(header.magic));
+        header.version = SCORE_MAP_VERSION;
+        header.width = picture->width;
+        header.height = picture->height;
+        header.numberOfObjects = numberOfObjects;
+        fwrite(&header, sizeof(header), 1, fp);
+        for (int i = 0; i < numberOfObjects; i++)
+        {
+            fwrite(&objectRecords[i], sizeof(ScoreMapObjectRecord), 1, fp);
+            fwrite(records[i], sizeof(ScoreRecord), objectRecords[i].numberOfRecords, fp);
+        }
+        fclose(fp);
+        if (rename(temporaryFile, file) != 0)
+            remove(temporaryFile);
+    }
+
+    for (int i = 0; i < numberOfObjects; i++)
+        free(records[i]);
+    free(records);
+    free(objectRecords);
+}
+
+/*
+ * Whether every record of a score map read from a file is a position of the object in the picture
+ */
+static int validRecords(ScoreRecord *records, int numberOfRecords, Picture *picture, Object *object)
+{
+    for (int r = 0; r < numberOfRecords; r++)
+        if (records[r].position < 0 || records[r].position / picture->width > picture->height - object->height ||
+            records[r].position % picture->width > picture->width - object->width)
+            return 0;
+    return 1;
+}
+
+int lookupScoreMap(ScoreMaps *scoreMaps, Picture *picture, Object *objects, int numberOfObjects, double matchingThreshold, Logs *log, Arena *arena)
+{
+    char file[MAX_SCORE_MAP_PATH];
+    scoreMapFileName(scoreMaps, picture, file);
+    FILE *fp = fopen(file, "rb");
+    if (fp == NULL)
+        return 0;
+
+    ScoreMapFileHeader header;
+    struct stat fileStatus;
+    if (fstat(fileno(fp), &fileStatus) != 0 || fread(&header, sizeof(header), 1, fp) != 1 || memcmp(header.magic, SCORE_MAP_MAGIC, sizeof(header.magic)) != 0 || header.version != SCORE_MAP_VERSION ||
+        header.width != picture->width || header.height != picture->height || header.numberOfObjects != numberOfObjects)
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    Logs found;
+    found.pictureID = picture->ID;
+    found.numObjectsFound = 0;
+    found.searchTime = 0;
+    allocateLogArrays(&found, numberOfObjects, arena);
+
+    int complete = 1;
+    for (int i = 0; i < numberOfObjects && complete; i++)
+    {
+        ScoreMapObjectRecord objectRecord;
+        // the counts come from a file, so they are bounded by the rest of it before they size anything
+        complete = fread(&objectRecord, sizeof(objectRecord), 1, fp) == 1 && objectRecord.objectID == objects[i].ID && objectRecord.numberOfRecords >= 0 &&
+                   objectRecord.numberOfRecords <= (fileStatus.st_size - ftell(fp)) / (long long)sizeof(ScoreRecord);
+        if (!complete)
+            break;
+        ScoreRecord *records = (ScoreRecord *)malloc((objectRecord.numberOfRecords + 1) * sizeof(ScoreRecord));
+        checkMalloc(records, "record lows");
+        complete = (int)fread(records, sizeof(ScoreRecord), objectRecord.numberOfRecords, fp) == objectRecord.numberOfRecords &&
+                   validRecords(records, objectRecord.numberOfRecords, picture, &objects[i]);
+        if (complete)
+            addFirstMatch(&found, picture, objects[i].ID, records, objectRecord.numberOfRecords, matchingThreshold, objectRecord.scanTime);
+        found.searchTime += objectRecord.scanTime;
+        free(records);
+    }
+    fclose(fp);
+
+    // arrays of an arena are released with the arena
+    if (!complete && arena == NULL)
+    {
+        free(found.objectIDs);
+        free(found.objectPositions);
+        free(found.objectScores);
+        free(found.objectTimes);
+        free(found.objectOrientations);
+    }
+    if (!complete)
+        return 0;
+    *log = found;
+    return 1;
+}
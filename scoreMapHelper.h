@@ -0,0 +1,108 @@
+#pragma once
+#include "helper.h"
+#include "cacheHelper.h"
+
+#define SCORE_MAP_MAGIC "SIRS"
+#define SCORE_MAP_VERSION 1
+#define SCORE_MAP_EXTENSION ".scores"
+#define MAX_SCORE_MAP_PATH 4096
+
+/*
+ * The first match for a threshold t is the first position in row-major order whose value is below t. Every earlier
+ * position has a value of at least t, so that position is a record low: its value is below the values of all earlier
+ * positions. A score map keeps only the record lows of every object, and the first record low below t answers any t.
+ *
+ * Score map file layout (native byte order): one ScoreMapFileHeader, then for every object one ScoreMapObjectRecord
+ * followed by its numberOfRecords ScoreRecords in row-major order. The file name is the hexadecimal key of the
+ * picture colors and the object set, the threshold is not part of it.
+ */
+struct ScoreMapFileHeaderStruct
+{
+    char magic[4];
+    int version;
+    int width;
+    int height;
+    int numberOfObjects;
+    int reserved;
+};
+typedef struct ScoreMapFileHeaderStruct ScoreMapFileHeader;
+
+struct ScoreMapObjectRecordStruct
+{
+    int objectID;
+    int numberOfRecords;
+    double scanTime;
+};
+typedef struct ScoreMapObjectRecordStruct ScoreMapObjectRecord;
+
+struct ScoreRecordStruct
+{
+    int position; // row * picture width + column
+    int reserved;
+    double score;
+};
+typedef struct ScoreRecordStruct ScoreRecord;
+
+struct ScoreMapsStruct
+{
+    const char *directory;
+    CacheKey objectsKey;
+};
+typedef struct ScoreMapsStruct ScoreMaps;
+
+/*
+ * This function opens a score map directory, creating it if needed
+ * @param scoreMaps: the score maps
+ * @param directory: the score map directory
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void openScoreMaps(ScoreMaps *scoreMaps, const char *directory, Object *objects, int numberOfObjects);
+
+/*
+ * This function finds the record lows of an object in a picture. A position stops being summed once its partial
+ * value reaches the lowest value so far, so only positions that can be record lows are summed completely.
+ * @param picture: pointer to the picture
+ * @param object: pointer to the object
+ * @param numberOfRecords: the number of record lows
+ * @return: the record lows in row-major order, released with free
+ */
+ScoreRecord *calculateRecordLows(Picture *picture, Object *object, int *numberOfRecords);
+
+/*
+ * This function finds the first match of an object for a threshold from its record lows. Every position before the
+ * first record low below the threshold has a value at least the record low before it, so it is the first match.
+ * @param records: the record lows in row-major order
+ * @param numberOfRecords: the number of record lows
+ * @param matchingThreshold: the matching threshold
+ * @return: the index of the first record low below the threshold, or NOT_FOUND
+ */
+int findFirstRecordBelow(ScoreRecord *records, int numberOfRecords, double matchingThreshold);
+
+/*
+ * This function searches the objects in a picture like findObjectsInPicture, from the record lows of every object,
+ * and writes the record lows to the score map of the picture
+ * @param scoreMaps: the score maps
+ * @param picture: pointer to the picture
+ * @param objects: the array of objects
+ * @param log: the log of the picture, the found objects are in object order
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold
+ * @param numThreads: the number of threads searching objects in parallel, 0 for one thread per object
+ * @return: void
+ */
+void findObjectsWithScoreMap(ScoreMaps *scoreMaps, Picture *picture, Object *objects, Logs *log, int numberOfObjects, double matchingThreshold, int numThreads);
+
+/*
+ * This function answers a picture from its score map
+ * @param scoreMaps: the score maps
+ * @param picture: pointer to the picture
+ * @param objects: the array of objects
+ * @param numberOfObjects: the number of objects
+ * @param matchingThreshold: the matching threshold
+ * @param log: the log, filled when the picture has a score map
+ * @param arena: the arena of the object arrays of the log, NULL to allocate them with malloc
+ * @return: 1 if the picture has a valid score map, 0 otherwise
+ */
+int lookupScoreMap(ScoreMaps *scoreMaps, Picture *picture, Object *objects, int numberOfObjects, double matchingThreshold, Logs *log, Arena *arena);
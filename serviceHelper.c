@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "serviceHelper.h"
+#include "imageHelper.h"
+
+void prepareSpoolDirectory(const char *spoolDirectory)
+{
+    char path[MAX_SPOOL_PATH];
+    const char *subdirectories[] = {SPOOL_WORK_DIRECTORY, SPOOL_RESULTS_DIRECTORY};
+
+    for (int i = 0; i < 2; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", spoolDirectory, subdirectories[i]);
+        if (mkdir(path, 0755) != 0)
+        {
+            struct stat pathStatus;
+            if (stat(path, &pathStatus) != 0 || !S_ISDIR(pathStatus.st_mode))
+                checkRead(0, 1, path);
+        }
+    }
+}
+
+/*
+ * This function finds the job with the smallest name in the spool directory
+ * @return: 1 if there is a job, 0 otherwise
+ */
+static int findSpoolJob(const char *spoolDirectory, char *jobName)
+{
+    DIR *directory = opendir(spoolDirectory);
+    checkMalloc(directory, spoolDirectory);
+
+    int found = 0;
+    char path[MAX_SPOOL_PATH];
+    for (struct dirent *entry = readdir(directory); entry != NULL; entry = readdir(directory))
+    {
+        struct stat fileStatus;
+        snprintf(path, sizeof(path), "%s/%s", spoolDirectory, entry->d_name);
+        if (entry->d_name[0] == '.' || strcmp(entry->d_name, SPOOL_STOP_FILE) == 0 || stat(path, &fileStatus) != 0 || !S_ISREG(fileStatus.st_mode))
+            continue;
+        if (!found || strcmp(entry->d_name, jobName) < 0)
+        {
+            snprintf(jobName, MAX_SPOOL_PATH, "%s", entry->d_name);
+            found = 1;
+        }
+    }
+    closedir(directory);
+    return found;
+}
+
+int waitForSpoolJob(const char *spoolDirectory, char *jobName, char *jobFile)
+{
+    char path[MAX_SPOOL_PATH];
+
+    while (1)
+    {
+        if (findSpoolJob(spoolDirectory, jobName))
+        {
+            // the rename claims the job, it fails if another service claimed it first
+            snprintf(path, sizeof(path), "%s/%s", spoolDirectory, jobName);
+            snprintf(jobFile, MAX_SPOOL_PATH, "%s/%s/%s", spoolDirectory, SPOOL_WORK_DIRECTORY, jobName);
+            if (rename(path, jobFile) == 0)
+                return SPOOL_JOB;
+            continue;
+        }
+
+        // jobs already in the spool directory are served before stopping
+        snprintf(path, sizeof(path), "%s/%s", spoolDirectory, SPOOL_STOP_FILE);
+        if (access(path, F_OK) == 0)
+        {
+            remove(path);
+            return SPOOL_STOP;
+        }
+        usleep(SPOOL_POLL_MICROSECONDS);
+    }
+}
+
+static int isImageFile(const char *file)
+{
+    size_t length = strlen(file);
+    return length > 4 && (strcasecmp(file + length - 4, ".pgm") == 0 || strcasecmp(file + length - 4, ".raw") == 0);
+}
+
+const char *readJobPictures(const char *jobFile, Picture **pictures, int *numberOfPictures)
+{
+    if (isImageFile(jobFile))
+    {
+        *pictures = (Picture *)malloc(sizeof(Picture));
+        checkMalloc(*pictures, "pictures array");
+        const char *error = parseImagePicture(jobFile, 1, *pictures);
+        *numberOfPictures = 1;
+        if (error != NULL)
+        {
+            free(*pictures);
+            *numberOfPictures = 0;
+        }
+        return error;
+    }
+
+    // the resident objects and threshold are used, the ones of the job file are dropped
+    Object *objects;
+    double matchingThreshold;
+    int numberOfObjects;
+    const char *error = parseInputFile(jobFile, pictures, &objects, &matchingThreshold, numberOfPictures, &numberOfObjects);
+    if (error == NULL)
+        freeObjects(objects, numberOfObjects);
+    return error;
+}
+
+void publishJobResult(const char *spoolDirectory, const char *jobName, const char *jobFile, Logs *logs, int numberOfLogs, int resultFormat)
+{
+    char resultFile[MAX_SPOOL_PATH], temporaryFile[MAX_SPOOL_PATH];
+    const char *outputFile = outputFileName(resultFormat);
+
+    // the result has the extension of the output file of the format
+    snprintf(resultFile, sizeof(resultFile), "%s/%s/%s%s", spoolDirectory, SPOOL_RESULTS_DIRECTORY, jobName, strrchr(outputFile, '.'));
+    snprintf(temporaryFile, sizeof(temporaryFile), "%s/%s/.%s.tmp", spoolDirectory, SPOOL_RESULTS_DIRECTORY, jobName);
+    writeLogs(temporaryFile, &logs, numberOfLogs, resultFormat);
+    if (rename(temporaryFile, resultFile) != 0)
+        checkRead(0, 1, resultFile);
+    remove(jobFile);
+}
+
+void publishJobError(const char *spoolDirectory, const char *jobName, const char *jobFile, const char *error)
+{
+    char resultFile[MAX_SPOOL_PATH], temporaryFile[MAX_SPOOL_PATH];
+    snprintf(resultFile, sizeof(resultFile), "%s/%s/%s%s", spoolDirectory, SPOOL_RESULTS_DIRECTORY, jobName, SPOOL_ERROR_EXTENSION);
+    snprintf(temporaryFile, sizeof(temporaryFile), "%s/%s/.%s.tmp", spoolDirectory, SPOOL_RESULTS_DIRECTORY, jobName);
+    FILE *fp = fopen(temporaryFile, "w");
+    checkMalloc(fp, temporaryFile);
+    fprintf(fp, "Error reading %s\n", error);
+    fclose(fp);
+    if (rename(temporaryFile, resultFile) != 0)
+        checkRead(0, 1, resultFile);
+    remove(jobFile);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "helper.h"
+
+#define SPOOL_WORK_DIRECTORY "work"
+#define SPOOL_RESULTS_DIRECTORY "results"
+#define SPOOL_STOP_FILE "STOP"
+#define SPOOL_POLL_MICROSECONDS 50000
+#define MAX_SPOOL_PATH 4096
+#define SPOOL_JOB 1
+#define SPOOL_STOP 2
+#define SPOOL_ERROR_EXTENSION ".error"
+
+/*
+ * Service mode: the objects stay resident on every process and picture jobs are files dropped into a spool directory.
+ * A job is an image (PGM or raw) or an input file whose pictures are searched, its objects and threshold are ignored.
+ * Jobs should be written under a name starting with a dot and renamed when complete, dot files are never picked up.
+ * A claimed job is moved to the work subdirectory, its result is written to the results subdirectory under the job name
+ * with the extension of the result format, and a file named SPOOL_STOP_FILE shuts the service down.
+ * A job that cannot be read gets an error result with SPOOL_ERROR_EXTENSION instead, and the service keeps serving.
+ */
+
+/*
+ * This function creates the work and results subdirectories of a spool directory
+ * @param spoolDirectory: the spool directory
+ * @return: void
+ */
+void prepareSpoolDirectory(const char *spoolDirectory);
+
+/*
+ * This function waits until a job or the stop file appears in the spool directory, and claims the job
+ * with the smallest name by moving it to the work subdirectory
+ * @param spoolDirectory: the spool directory
+ * @param jobName: the name of the claimed job, MAX_SPOOL_PATH characters
+ * @param jobFile: the path of the claimed job in the work subdirectory, MAX_SPOOL_PATH characters
+ * @return: SPOOL_JOB when a job was claimed, SPOOL_STOP when the stop file was found and removed
+ */
+int waitForSpoolJob(const char *spoolDirectory, char *jobName, char *jobFile);
+
+/*
+ * This function reads the pictures of a job without aborting on a malformed or truncated job
+ * @param jobFile: the job file
+ * @param pictures: the array of pictures, only allocated on success
+ * @param numberOfPictures: the number of pictures
+ * @return: NULL, or what could not be read
+ */
+const char *readJobPictures(const char *jobFile, Picture **pictures, int *numberOfPictures);
+
+/*
+ * This function publishes the result of a job: the result is written to a temporary file first and renamed,
+ * so readers of the results subdirectory never see a partial result. The claimed job file is removed.
+ * @param spoolDirectory: the spool directory
+ * @param jobName: the name of the job
+ * @param jobFile: the path of the claimed job
+ * @param logs: the logs of the pictures of the job
+ * @param numberOfLogs: the number of logs
+ * @param resultFormat: the result format
+ * @return: void
+ */
+void publishJobResult(const char *spoolDirectory, const char *jobName, const char *jobFile, Logs *logs, int numberOfLogs, int resultFormat);
+
+/*
+ * This function publishes the error of a job that could not be read, like publishJobResult,
+ * to the results subdirectory under the job name with SPOOL_ERROR_EXTENSION. The claimed job file is removed.
+ * @param spoolDirectory: the spool directory
+ * @param jobName: the name of the job
+ * @param jobFile: the path of the claimed job
+ * @param error: what could not be read
+ * @return: void
+ */
+void publishJobError(const char *spoolDirectory, const char *jobName, const char *jobFile, const char *error);
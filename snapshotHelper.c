@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshotHelper.h"
+
+static long long alignOffset(long long offset)
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+static void writePadding(FILE *fp, long long offset)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {0};
+    long long position = ftell(fp);
+    if (offset > position)
+        fwrite(zeros, 1, offset - position, fp);
+}
+
+void writeObjectSnapshot(const char *snapshotFile, Object *objects, int numberOfObjects)
+{
+    SnapshotFileHeader header;
+    SnapshotObjectRecord *records = (SnapshotObjectRecord *)calloc(numberOfObjects, sizeof(SnapshotObjectRecord));
+    checkMalloc(records, "snapshot records array");
+
+    // lay out the data blocks behind the header and the records
+    long long offset = sizeof(SnapshotFileHeader) + (long long)numberOfObjects * sizeof(SnapshotObjectRecord);
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        if (objects[i].colorCounts == NULL)
+            computeColorCounts(&objects[i]);
+        records[i].ID = objects[i].ID;
+        records[i].width = objects[i].width;
+        records[i].height = objects[i].height;
+        records[i].pitch = objects[i].pitch;
+        records[i].colorsOffset = offset = alignOffset(offset);
+        offset += (long long)objects[i].pitch * objects[i].height * sizeof(int);
+        if (objects[i].colorCounts != NULL)
+        {
+            records[i].colorCountsOffset = offset = alignOffset(offset);
+            offset += HISTOGRAM_COLORS * sizeof(int);
+        }
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_FILE_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_FILE_VERSION;
+    header.numberOfObjects = numberOfObjects;
+    header.histogramColors = HISTOGRAM_COLORS;
+    header.rowAlignment = ROW_ALIGNMENT;
+    header.fileSize = offset;
+
+    FILE *fp = fopen(snapshotFile, "wb");
+    checkMalloc(fp, snapshotFile);
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(records, sizeof(SnapshotObjectRecord), numberOfObjects, fp);
+    for (int i = 0; i < numberOfObjects; i++)
+    {
+        writePadding(fp, records[i].colorsOffset);
+        fwrite(objects[i].subColorsMatrix, sizeof(int), (size_t)objects[i].pitch * objects[i].height, fp);
+        if (records[i].colorCountsOffset != 0)
+        {
+            writePadding(fp, records[i].colorCountsOffset);
+            fwrite(objects[i].colorCounts, sizeof(int), HISTOGRAM_COLORS, fp);
+        }
+    }
+    checkRead(ftell(fp) == offset, 1, "snapshot file size");
+    fclose(fp);
+    free(records);
+}
+
+void loadObjectSnapshot(const char *snapshotFile, ObjectSnapshot *snapshot)
+{
+    struct stat fileStatus;
+    int fd = open(snapshotFile, O_RDONLY);
+    if (fd < 0 || fstat(fd, &fileStatus) != 0)
+        checkRead(0, 1, snapshotFile);
+    snapshot->size = fileStatus.st_size;
+    if (snapshot->size < sizeof(SnapshotFileHeader))
+        checkRead(0, 1, "snapshot header");
+    snapshot->mapping = mmap(NULL, snapshot->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (snapshot->mapping == MAP_FAILED)
+        checkMalloc(NULL, snapshotFile);
+
+    // a snapshot of another build would have another histogram or row layout
+    const char *base = (const char *)snapshot->mapping;
+    const SnapshotFileHeader *header = (const SnapshotFileHeader *)base;
+    checkRead(memcmp(header->magic, SNAPSHOT_FILE_MAGIC, sizeof(header->magic)) == 0, 1, "snapshot file magic");
+    checkRead(header->version, SNAPSHOT_FILE_VERSION, "snapshot file version");
+    checkRead(header->histogramColors, HISTOGRAM_COLORS, "snapshot histogram colors");
+    checkRead(header->rowAlignment, ROW_ALIGNMENT, "snapshot row alignment");
+    checkRead(header->fileSize == (long long)snapshot->size, 1, "snapshot file size");
+
+    // the records must fit in the file before any of them is read
+    long long dataStart = sizeof(SnapshotFileHeader) + (long long)header->numberOfObjects * sizeof(SnapshotObjectRecord);
+    if (header->numberOfObjects < 0 || dataStart > header->fileSize)
+        checkRead(0, 1, "snapshot number of objects");
+
+    snapshot->numberOfObjects = header->numberOfObjects;
+    snapshot->objects = (Object *)malloc((snapshot->numberOfObjects + 1) * sizeof(Object));
+    checkMalloc(snapshot->objects, "objects array");
+    const SnapshotObjectRecord *records = (const SnapshotObjectRecord *)(base + sizeof(SnapshotFileHeader));
+    for (int i = 0; i < snapshot->numberOfObjects; i++)
+    {
+        Object *object = &snapshot->objects[i];
+        const SnapshotObjectRecord *record = &records[i];
+        if (record->width < 0 || record->height < 0 || record->pitch < record->width)
+            checkRead(0, 1, "snapshot object size");
+
+        // the data blocks lie behind the records, int aligned and inside the file, the histogram offset is 0 when there is none
+        long long colorsEnd = record->colorsOffset + (long long)record->pitch * record->height * (long long)sizeof(int);
+        long long colorCountsEnd = record->colorCountsOffset + HISTOGRAM_COLORS * (long long)sizeof(int);
+        if (record->colorsOffset < dataStart || record->colorsOffset % sizeof(int) != 0 || colorsEnd > header->fileSize)
+            checkRead(0, 1, "snapshot object colors inside the file");
+        if (record->colorCountsOffset != 0 &&
+            (record->colorCountsOffset < dataStart || record->colorCountsOffset % sizeof(int) != 0 || colorCountsEnd > header->fileSize))
+            checkRead(0, 1, "snapshot object histogram inside the file");
+        object->ID = records[i].ID;
+        object->width = records[i].width;
+        object->height = records[i].height;
+        object->pitch = records[i].pitch;
+        object->subColorsMatrix = (int *)(base + records[i].colorsOffset);
+        object->colorCounts = records[i].colorCountsOffset != 0 ? (int *)(base + records[i].colorCountsOffset) : NULL;
+        object->visitBlocks = NULL;
+    }
+}
+
+void freeObjectSnapshot(ObjectSnapshot *snapshot)
+{
+    // the derived data of the objects is not part of the mapping
+    for (int i = 0; i < snapshot->numberOfObjects; i++)
+        free(snapshot->objects[i].visitBlocks);
+    free(snapshot->objects);
+    munmap(snapshot->mapping, snapshot->size);
+}
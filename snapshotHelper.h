@@ -0,0 +1,68 @@
+#pragma once
+#include "helper.h"
+
+#define SNAPSHOT_FILE_MAGIC "SIRO"
+#define SNAPSHOT_FILE_VERSION 1
+#define SNAPSHOT_ALIGNMENT 64
+
+/*
+ * Object snapshot file layout (native byte order): one SnapshotFileHeader, numberOfObjects SnapshotObjectRecords,
+ * then the data blocks, each starting on a SNAPSHOT_ALIGNMENT boundary. The colors of an object are stored with
+ * their row padding (height rows of pitch colors), so the mapped file is used in place, and the cumulative
+ * color histogram (HISTOGRAM_COLORS ints, see computeColorCounts) follows when the object has one.
+ */
+struct SnapshotFileHeaderStruct
+{
+    char magic[4];
+    int version;
+    int numberOfObjects;
+    int histogramColors;
+    int rowAlignment;
+    int reserved;
+    long long fileSize;
+};
+typedef struct SnapshotFileHeaderStruct SnapshotFileHeader;
+
+struct SnapshotObjectRecordStruct
+{
+    int ID;
+    int width;
+    int height;
+    int pitch;
+    long long colorsOffset;
+    long long colorCountsOffset; // 0 when the object has no histogram
+};
+typedef struct SnapshotObjectRecordStruct SnapshotObjectRecord;
+
+struct ObjectSnapshotStruct
+{
+    void *mapping;
+    size_t size;
+    int numberOfObjects;
+    Object *objects; // the colors and histograms point into the read-only mapping
+};
+typedef struct ObjectSnapshotStruct ObjectSnapshot;
+
+/*
+ * This function writes the objects and their color histograms to a snapshot file
+ * @param snapshotFile: the snapshot file name
+ * @param objects: the array of objects, computeColorCounts is called for objects without a histogram
+ * @param numberOfObjects: the number of objects
+ * @return: void
+ */
+void writeObjectSnapshot(const char *snapshotFile, Object *objects, int numberOfObjects);
+
+/*
+ * This function maps a snapshot file read-only and builds the objects on top of the mapping
+ * @param snapshotFile: the snapshot file name
+ * @param snapshot: the snapshot
+ * @return: void
+ */
+void loadObjectSnapshot(const char *snapshotFile, ObjectSnapshot *snapshot);
+
+/*
+ * This function unmaps a snapshot and frees its objects array and the visit blocks of its objects
+ * @param snapshot: the snapshot
+ * @return: void
+ */
+void freeObjectSnapshot(ObjectSnapshot *snapshot);
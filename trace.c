@@ -0,0 +1,108 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "helper.h"
+#include "trace.h"
+
+static int traceEnabled = 0;
+static double traceOrigin = 0;
+static int traceGeneration = 0;
+static int numTraceBuffers = 0;
+static TraceBuffer *traceBuffers = NULL;
+static __thread TraceBuffer *threadTraceBuffer = NULL;
+static __thread int threadTraceGeneration = -1;
+
+static double monotonicMicroseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec * 1e-3;
+}
+
+void traceEnable(void)
+{
+    traceOrigin = monotonicMicroseconds();
+    traceEnabled = 1;
+}
+
+double traceNow(void)
+{
+    return monotonicMicroseconds() - traceOrigin;
+}
+
+void traceRecord(const char *name, double start, double end, int ID)
+{
+    if (!traceEnabled)
+        return;
+
+    // the first event of a thread registers its ring buffer, buffers of an exported trace are gone
+    if (threadTraceGeneration != traceGeneration)
+    {
+        threadTraceBuffer = (TraceBuffer *)malloc(sizeof(TraceBuffer));
+        checkMalloc(threadTraceBuffer, "trace buffer");
+        threadTraceBuffer->numEventsRecorded = 0;
+        threadTraceGeneration = traceGeneration;
+        #pragma omp critical(traceBuffers)
+        {
+            threadTraceBuffer->threadIndex = numTraceBuffers++;
+            threadTraceBuffer->next = traceBuffers;
+            traceBuffers = threadTraceBuffer;
+        }
+    }
+
+    TraceEvent *event = &threadTraceBuffer->events[threadTraceBuffer->numEventsRecorded % TRACE_BUFFER_EVENTS];
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+    event->ID = ID;
+    threadTraceBuffer->numEventsRecorded++;
+}
+
+void traceExport(const char *traceFile, int rank, int size)
+{
+    long numEvents = 0;
+    for (TraceBuffer *buffer = traceBuffers; buffer != NULL; buffer = buffer->next)
+        numEvents += buffer->numEventsRecorded < TRACE_BUFFER_EVENTS ? buffer->numEventsRecorded : TRACE_BUFFER_EVENTS;
+
+    char *fragment = (char *)malloc(2 * MAX_TRACE_HEADER_LENGTH + (numEvents + 1) * MAX_TRACE_EVENT_LENGTH);
+    checkMalloc(fragment, "trace fragment");
+
+    // every process starts with its name, so the fragments can always be joined with commas
+    int length = 0;
+    if (rank == 0)
+        length += sprintf(fragment + length, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    else
+        length += sprintf(fragment + length, ",");
+    length += sprintf(fragment + length, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", rank, rank);
+
+    for (TraceBuffer *buffer = traceBuffers; buffer != NULL; buffer = buffer->next)
+    {
+        // oldest event first; a wrapped ring buffer starts at its write position
+        long first = buffer->numEventsRecorded < TRACE_BUFFER_EVENTS ? 0 : buffer->numEventsRecorded - TRACE_BUFFER_EVENTS;
+        for (long i = first; i < buffer->numEventsRecorded; i++)
+        {
+            TraceEvent *event = &buffer->events[i % TRACE_BUFFER_EVENTS];
+            length += sprintf(fragment + length, ",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%d}}",
+                              event->name, rank, buffer->threadIndex, event->start, event->duration, event->ID);
+        }
+    }
+
+    if (rank == size - 1)
+        length += sprintf(fragment + length, "]}\n");
+
+    // one record per process, placed in rank order, a text format has no file header
+    writeLogsParallel(traceFile, &fragment, &length, &rank, 1, size, RESULT_FORMAT_TEXT);
+
+    free(fragment);
+    while (traceBuffers != NULL)
+    {
+        TraceBuffer *next = traceBuffers->next;
+        free(traceBuffers);
+        traceBuffers = next;
+    }
+    numTraceBuffers = 0;
+    traceGeneration++;
+    traceEnabled = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#define TRACE_FILE "trace.json"
+#define TRACE_BUFFER_EVENTS 65536
+#define MAX_TRACE_EVENT_LENGTH 192
+#define MAX_TRACE_HEADER_LENGTH 128
+
+struct TraceEventStruct
+{
+    const char *name;
+    double start;
+    double duration;
+    int ID;
+};
+typedef struct TraceEventStruct TraceEvent;
+
+/*
+ * Ring buffer of the events recorded by one thread. When it is full the oldest events are overwritten.
+ */
+struct TraceBufferStruct
+{
+    int threadIndex;
+    long numEventsRecorded;
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+    struct TraceBufferStruct *next;
+};
+typedef struct TraceBufferStruct TraceBuffer;
+
+/*
+ * This function enables tracing and sets the time origin of this process.
+ * Must be called by all processes right after a barrier, so the time lines of the processes line up.
+ * @return: void
+ */
+void traceEnable(void);
+
+/*
+ * This function returns the current trace time
+ * @return: microseconds since traceEnable was called
+ */
+double traceNow(void);
+
+/*
+ * This function records a completed stage in the ring buffer of the calling thread. Does nothing when tracing is disabled.
+ * @param name: the stage name, must be a string literal
+ * @param start: the start time of the stage, from traceNow
+ * @param end: the end time of the stage, from traceNow
+ * @param ID: the picture or object ID the stage worked on, or -1
+ * @return: void
+ */
+void traceRecord(const char *name, double start, double end, int ID);
+
+/*
+ * This function writes the events of all processes to a Chrome trace (Perfetto) JSON file and frees the ring buffers.
+ * Every process is shown as its own track group and every thread as a track. Must be called by all processes.
+ * @param traceFile: the trace file name
+ * @param rank: the rank of this process
+ * @param size: the number of processes
+ * @return: void
+ */
+void traceExport(const char *traceFile, int rank, int size);
@@ -0,0 +1,701 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "helper.h"
+#include "cpuHelper.h"
+#include "scoreMapHelper.h"
+#include "orientationHelper.h"
+#include "maskHelper.h"
+#include "reference.h"
+
+#define MAX_VERIFY_BACKENDS 16
+#define MAX_RANDOM_DIMENSION 64
+#define NUM_ADVERSARIAL_CASES 6
+#define NUM_STRIP_COUNTS 6
+#define STRIP_CASES_DIVISOR 4
+#define NUM_SYMMETRY_KINDS 3
+#define NUM_MASK_KINDS 3
+#define MAX_MASK_THRESHOLDS 5
+
+struct VerifyOptionsStruct
+{
+    int numberOfCases;
+    unsigned int seed;
+    const char *inputFile;
+    int verbose;
+    int numberOfBackends;
+    const char *backends[MAX_VERIFY_BACKENDS];
+};
+typedef struct VerifyOptionsStruct VerifyOptions;
+
+struct VerifyStatsStruct
+{
+    long numberOfChecks;
+    long numberOfMismatches;
+};
+typedef struct VerifyStatsStruct VerifyStats;
+
+static void fail(const char *message, const char *detail)
+{
+    fprintf(stderr, "Error: %s %s\n", message, detail);
+    exit(1);
+}
+
+static void parseVerifyOptions(int argc, char *argv[], VerifyOptions *options)
+{
+    memset(options, 0, sizeof(*options));
+    options->numberOfCases = 2000;
+    options->seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--verbose") == 0)
+            options->verbose = 1;
+        else if (strcmp(argv[i], "--cases") == 0 && i + 1 < argc)
+            options->numberOfCases = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            options->seed = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+            options->inputFile = argv[++i];
+        else if (strcmp(argv[i], "--backends") == 0 && i + 1 < argc)
+            for (char *name = strtok(argv[++i], ","); name != NULL && options->numberOfBackends < MAX_VERIFY_BACKENDS; name = strtok(NULL, ","))
+                options->backends[options->numberOfBackends++] = name;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--backends a,b] [--cases n] [--seed s] [--input file] [--verbose]\n", argv[0]);
+            exit(1);
+        }
+    }
+
+    // all CPU backends by default, the GPU backend has to be asked for
+    if (options->numberOfBackends == 0)
+        for (int i = 0; i < numberOfMatchingBackends && i < MAX_VERIFY_BACKENDS; i++)
+            if (strcmp(matchingBackends[i].name, "gpu") != 0)
+                options->backends[options->numberOfBackends++] = matchingBackends[i].name;
+    for (int i = 0; i < options->numberOfBackends; i++)
+        if (findMatchingBackend(options->backends[i]) == NULL)
+            fail("unknown backend", options->backends[i]);
+}
+
+static int randomInt(int min, int max)
+{
+    return min + rand() % (max - min + 1);
+}
+
+/*
+ * The adversarial cases fill their matrices as if they had no row padding, so their pitch is the width
+ */
+static void allocateCase(Picture *picture, Object *object, int pictureDimension, int objectDimension)
+{
+    picture->ID = 1;
+    object->ID = 1;
+    picture->width = picture->height = picture->pitch = pictureDimension;
+    object->width = object->height = object->pitch = objectDimension;
+    picture->colorsMatrix = (int *)malloc(pictureDimension * pictureDimension * sizeof(int));
+    object->subColorsMatrix = (int *)malloc(objectDimension * objectDimension * sizeof(int));
+    object->colorCounts = NULL;
+    object->visitBlocks = NULL;
+    if (picture->colorsMatrix == NULL || object->subColorsMatrix == NULL)
+        fail("allocating memory for", "test case");
+}
+
+static void freeCase(Picture *picture, Object *object)
+{
+    free(picture->colorsMatrix);
+    free(object->subColorsMatrix);
+    free(object->colorCounts);
+    free(object->visitBlocks);
+}
+
+static void formatPosition(Picture *picture, Object *object, int upperLeftCorner, char *text)
+{
+    if (upperLeftCorner == NOT_FOUND)
+        sprintf(text, "not found");
+    else
+    {
+        int row = upperLeftCorner / picture->width;
+        int column = upperLeftCorner % picture->width;
+        sprintf(text, "Position(%d,%d) value %.17g", row, column, referenceMatchingValue(picture, object, row, column));
+    }
+}
+
+/*
+ * This function counts and reports one first match found by a method against the first match of the reference
+ * @return: void
+ */
+static void compareFirstMatch(VerifyOptions *options, VerifyStats *stats, const char *method, const char *description, Picture *picture,
+                              Object *object, double matchingThreshold, int expected, int upperLeftCorner)
+{
+    stats->numberOfChecks++;
+    if (upperLeftCorner == expected && !options->verbose)
+        return;
+
+    char expectedText[128], actualText[128];
+    formatPosition(picture, object, expected, expectedText);
+    formatPosition(picture, object, upperLeftCorner, actualText);
+    if (upperLeftCorner != expected)
+        stats->numberOfMismatches++;
+    printf("%s %s, %s, picture %d (%dx%d), object %d (%dx%d), threshold %.17g: reference %s, found %s\n",
+           upperLeftCorner == expected ? "OK" : "MISMATCH", method, description, picture->ID, picture->width,
+           picture->height, object->ID, object->width, object->height, matchingThreshold, expectedText, actualText);
+}
+
+/*
+ * This function runs every backend on one picture and object and compares the first match with the reference
+ * @return: void
+ */
+static void checkCase(VerifyOptions *options, VerifyStats *stats, const char *description, Picture *picture, Object *object, double matchingThreshold)
+{
+    int expected = referenceFirstMatch(picture, object, matchingThreshold);
+
+    for (int b = 0; b < options->numberOfBackends; b++)
+    {
+        char method[64];
+        int upperLeftCorner = NOT_FOUND;
+        findMatchingBackend(options->backends[b])->function(picture, object, &upperLeftCorner, matchingThreshold);
+        snprintf(method, sizeof(method), "backend %s", options->backends[b]);
+        compareFirstMatch(options, stats, method, description, picture, object, matchingThreshold, expected, upperLeftCorner);
+    }
+}
+
+/*
+ * Random rectangular pictures with padded rows and random zero colors and a random object
+ */
+static void fillRandomCase(Picture *picture, Object *object)
+{
+    picture->ID = object->ID = 1;
+    allocatePicture(picture, randomInt(1, MAX_RANDOM_DIMENSION), randomInt(1, MAX_RANDOM_DIMENSION));
+    allocateObject(object, randomInt(1, picture->width), randomInt(1, picture->height));
+
+    int zeroPercent = rand() % 3 == 0 ? randomInt(1, 30) : 0;
+    for (int i = 0; i < picture->height; i++)
+        for (int j = 0; j < picture->width; j++)
+            picture->colorsMatrix[i * picture->pitch + j] = rand() % 100 < zeroPercent ? 0 : randomInt(1, 100);
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+            object->subColorsMatrix[i * object->pitch + j] = randomInt(1, 100);
+
+    // half of the objects carry their color histogram like the objects of the workers
+    if (rand() % 2)
+        computeColorCounts(object);
+}
+
+/*
+ * This function copies an object into a picture at a position, every color moved by a random noise of at most noise
+ */
+static void plantObject(Picture *picture, Object *object, int row, int column, int noise)
+{
+    for (int i = 0; i < object->height; i++)
+        for (int j = 0; j < object->width; j++)
+        {
+            int color = object->subColorsMatrix[i * object->pitch + j] + randomInt(-noise, noise);
+            picture->colorsMatrix[(row + i) * picture->pitch + column + j] = color < 1 ? 1 : color > 100 ? 100 : color;
+        }
+}
+
+/*
+ * Random cases with the object planted with noise at a random position
+ */
+static void generateRandomCase(Picture *picture, Object *object, int *plantedRow, int *plantedColumn)
+{
+    fillRandomCase(picture, object);
+    int noise = randomInt(0, 3);
+    *plantedRow = randomInt(0, picture->height - object->height);
+    *plantedColumn = randomInt(0, picture->width - object->width);
+    plantObject(picture, object, *plantedRow, *plantedColumn, noise);
+
+    // half of the objects carry visit blocks ordered for the picture like the objects of the workers
+    if (rand() % 2)
+    {
+        computeVisitBlocks(object);
+        orderVisitBlocks(picture, object, 1);
+    }
+}
+
+static void verifyRandomCases(VerifyOptions *options, VerifyStats *stats)
+{
+    const double thresholds[] = {0.0, 0.01, 0.05, 0.1, 0.3, 1.0};
+    Picture picture;
+    Object object;
+    int plantedRow, plantedColumn;
+
+    for (int c = 0; c < options->numberOfCases; c++)
+    {
+        generateRandomCase(&picture, &object, &plantedRow, &plantedColumn);
+
+        double matchingThreshold = rand() % 2 ? thresholds[rand() % 6] : (double)rand() / RAND_MAX;
+        checkCase(options, stats, "random", &picture, &object, matchingThreshold);
+
+        // the planted value exactly on the threshold must not match, one ulp above it must
+        double value = referenceMatchingValue(&picture, &object, plantedRow, plantedColumn);
+        checkCase(options, stats, "threshold equal to planted value", &picture, &object, value);
+        checkCase(options, stats, "threshold one ulp above planted value", &picture, &object, nextafter(value, INFINITY));
+        checkCase(options, stats, "threshold one ulp below planted value", &picture, &object, nextafter(value, -INFINITY));
+
+        // the same at a random position, where the value is usually high
+        int row = randomInt(0, picture.height - object.height);
+        int column = randomInt(0, picture.width - object.width);
+        value = referenceMatchingValue(&picture, &object, row, column);
+        checkCase(options, stats, "threshold equal to random position value", &picture, &object, value);
+        checkCase(options, stats, "threshold one ulp above random position value", &picture, &object, nextafter(value, INFINITY));
+
+        freeCase(&picture, &object);
+    }
+}
+
+/*
+ * One search of a random case for several thresholds in a random order: random ones, and the planted value and
+ * the value of a random position with one ulp around them, every threshold is compared with its own reference search
+ */
+static void verifyThresholdCases(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture picture;
+    Object object;
+    int plantedRow, plantedColumn;
+
+    for (int c = 0; c < options->numberOfCases; c++)
+    {
+        generateRandomCase(&picture, &object, &plantedRow, &plantedColumn);
+
+        double plantedValue = referenceMatchingValue(&picture, &object, plantedRow, plantedColumn);
+        double randomValue = referenceMatchingValue(&picture, &object, randomInt(0, picture.height - object.height), randomInt(0, picture.width - object.width));
+        double thresholds[MAX_THRESHOLDS];
+        int upperLeftCorners[MAX_THRESHOLDS];
+        int numberOfThresholds = 0;
+        thresholds[numberOfThresholds++] = (double)rand() / RAND_MAX;
+        thresholds[numberOfThresholds++] = rand() % 2 ? 0.0 : 1.0;
+        for (int k = 0; k < 2; k++)
+        {
+            double value = k == 0 ? plantedValue : randomValue;
+            thresholds[numberOfThresholds++] = value;
+            thresholds[numberOfThresholds++] = nextafter(value, INFINITY);
+            thresholds[numberOfThresholds++] = nextafter(value, -INFINITY);
+        }
+        for (int t = numberOfThresholds - 1; t > 0; t--)
+        {
+            int other = randomInt(0, t);
+            double swapped = thresholds[t];
+            thresholds[t] = thresholds[other];
+            thresholds[other] = swapped;
+        }
+
+        calculateMatchingThresholds(&picture, &object, upperLeftCorners, thresholds, numberOfThresholds);
+        for (int t = 0; t < numberOfThresholds; t++)
+            compareFirstMatch(options, stats, "thresholds", "several thresholds in one search", &picture, &object, thresholds[t],
+                              referenceFirstMatch(&picture, &object, thresholds[t]), upperLeftCorners[t]);
+        freeCase(&picture, &object);
+    }
+}
+
+/*
+ * The record lows of one random case answer many thresholds, like a score map: random ones, the planted value and
+ * the value of a random position with one ulp around them, and every record low and one ulp above it
+ */
+static void verifyRecordLowCases(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture picture;
+    Object object;
+    int plantedRow, plantedColumn;
+
+    for (int c = 0; c < options->numberOfCases; c++)
+    {
+        generateRandomCase(&picture, &object, &plantedRow, &plantedColumn);
+        int numberOfRecords;
+        ScoreRecord *records = calculateRecordLows(&picture, &object, &numberOfRecords);
+
+        double plantedValue = referenceMatchingValue(&picture, &object, plantedRow, plantedColumn);
+        double randomValue = referenceMatchingValue(&picture, &object, randomInt(0, picture.height - object.height), randomInt(0, picture.width - object.width));
+        int numberOfThresholds = 0;
+        double *thresholds = (double *)malloc((2 * numberOfRecords + 10) * sizeof(double));
+        if (thresholds == NULL)
+            fail("allocating memory for", "thresholds");
+        thresholds[numberOfThresholds++] = 0.0;
+        thresholds[numberOfThresholds++] = 1.0;
+        thresholds[numberOfThresholds++] = (double)rand() / RAND_MAX;
+        thresholds[numberOfThresholds++] = (double)rand() / RAND_MAX;
+        for (int k = 0; k < 2; k++)
+        {
+            double value = k == 0 ? plantedValue : randomValue;
+            thresholds[numberOfThresholds++] = value;
+            thresholds[numberOfThresholds++] = nextafter(value, INFINITY);
+            thresholds[numberOfThresholds++] = nextafter(value, -INFINITY);
+        }
+        for (int r = 0; r < numberOfRecords; r++)
+        {
+            thresholds[numberOfThresholds++] = records[r].score;
+            thresholds[numberOfThresholds++] = nextafter(records[r].score, INFINITY);
+        }
+
+        for (int t = 0; t < numberOfThresholds; t++)
+        {
+            int r = findFirstRecordBelow(records, numberOfRecords, thresholds[t]);
+            compareFirstMatch(options, stats, "record lows", "thresholds from one record list", &picture, &object, thresholds[t],
+                              referenceFirstMatch(&picture, &object, thresholds[t]), r == NOT_FOUND ? NOT_FOUND : records[r].position);
+        }
+        free(thresholds);
+        free(records);
+        freeCase(&picture, &object);
+    }
+}
+
+/*
+ * Searches split into row strips, with several strip counts up to more strips than position rows, against the unsplit
+ * reference. The object is planted on the first row of a strip, on the last row of the strip before it, or in the last strip.
+ * Every case runs every backend at every strip count, so a fraction of the cases is enough.
+ */
+static void verifyStripCases(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture picture;
+    Object object;
+    Logs *log = (Logs *)malloc(sizeof(Logs));
+    if (log == NULL)
+        fail("allocating memory for", "log");
+    allocateLogArrays(log, 1, NULL);
+
+    for (int c = 0; c < (options->numberOfCases + STRIP_CASES_DIVISOR - 1) / STRIP_CASES_DIVISOR; c++)
+    {
+        fillRandomCase(&picture, &object);
+        int positionRows = picture.height - object.height + 1;
+        int stripCounts[NUM_STRIP_COUNTS] = {1, 2, 3, randomInt(4, 8), positionRows, positionRows + randomInt(1, 3)};
+
+        int plantedStrips = stripCounts[randomInt(1, NUM_STRIP_COUNTS - 1)];
+        int strip = randomInt(0, plantedStrips - 1);
+        int firstRow = (long long)strip * positionRows / plantedStrips;
+        int lastStripRow = (long long)(plantedStrips - 1) * positionRows / plantedStrips;
+        int plantedRow = rand() % 3 == 0 ? randomInt(lastStripRow, positionRows - 1) : rand() % 2 && firstRow > 0 ? firstRow - 1 : firstRow;
+        int plantedColumn = randomInt(0, picture.width - object.width);
+        plantObject(&picture, &object, plantedRow, plantedColumn, randomInt(0, 1));
+
+        double value = referenceMatchingValue(&picture, &object, plantedRow, plantedColumn);
+        double thresholds[] = {value, nextafter(value, INFINITY), nextafter(value, -INFINITY), (double)rand() / RAND_MAX};
+        for (int t = 0; t < 4; t++)
+        {
+            int expected = referenceFirstMatch(&picture, &object, thresholds[t]);
+            for (int b = 0; b < options->numberOfBackends; b++)
+                for (int n = 0; n < NUM_STRIP_COUNTS; n++)
+                {
+                    char method[64];
+                    log->numObjectsFound = 0;
+                    findObjectsInPicture(&picture, &object, log, 1, thresholds[t], findMatchingBackend(options->backends[b])->function, 1, stripCounts[n]);
+                    int upperLeftCorner = log->numObjectsFound > 0 ? log->objectPositions[0].row * picture.width + log->objectPositions[0].column : NOT_FOUND;
+                    snprintf(method, sizeof(method), "backend %s in %d strips", options->backends[b], stripCounts[n]);
+                    compareFirstMatch(options, stats, method, "object planted at a strip boundary", &picture, &object, thresholds[t], expected, upperLeftCorner);
+                }
+        }
+        freeCase(&picture, &object);
+    }
+    freeLogs(log, 1);
+}
+
+/*
+ * This function makes a random object symmetric: kind 1 mirrors its left half onto its right half, so the mirrored
+ * orientations equal the others, kind 2 turns it into a square of rings, so all orientations are equal. Kind 0 keeps it.
+ */
+static void makeSymmetric(Object *object, int kind)
+{
+    if (kind == 1)
+        for (int i = 0; i < object->height; i++)
+            for (int j = object->width / 2; j < object->width; j++)
+                object->subColorsMatrix[i * object->pitch + j] = object->subColorsMatrix[i * object->pitch + object->width - 1 - j];
+    else if (kind == 2)
+    {
+        int dimension = object->width < object->height ? object->width : object->height;
+        int ringColors[MAX_RANDOM_DIMENSION];
+        for (int r = 0; r < dimension; r++)
+            ringColors[r] = randomInt(1, 100);
+        free(object->subColorsMatrix);
+        free(object->colorCounts);
+        free(object->visitBlocks);
+        allocateObject(object, dimension, dimension);
+        for (int i = 0; i < dimension; i++)
+            for (int j = 0; j < dimension; j++)
+            {
+                int ring = i < j ? i : j;
+                ring = dimension - 1 - i < ring ? dimension - 1 - i : ring;
+                ring = dimension - 1 - j < ring ? dimension - 1 - j : ring;
+                object->subColorsMatrix[i * object->pitch + j] = ringColors[ring];
+            }
+    }
+}
+
+/*
+ * The search of all orientations at once against the reference search of every orientation of orientObject on its own:
+ * the first match is the lowest of their first matches, with the lowest orientation matching there. The objects are
+ * rectangular, mirror symmetric or fully symmetric, so some orientations are deduplicated, and an orientation is
+ * planted with noise. The search runs with the picture reciprocals and without them.
+ */
+static void verifyOrientationCases(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture picture;
+    Object object, variant;
+    double *reciprocals = (double *)malloc(((size_t)rowPitch(MAX_RANDOM_DIMENSION) * MAX_RANDOM_DIMENSION + 1) * sizeof(double));
+    if (reciprocals == NULL)
+        fail("allocating memory for", "reciprocals");
+
+    for (int c = 0; c < options->numberOfCases; c++)
+    {
+        fillRandomCase(&picture, &object);
+        makeSymmetric(&object, c % NUM_SYMMETRY_KINDS);
+        OrientedObject *oriented = orientObjects(&object, 1);
+
+        // plant an orientation where it fits, or the object itself
+        orientObject(&object, randomInt(0, NUMBER_OF_ORIENTATIONS - 1), &variant);
+        if (variant.width > picture.width || variant.height > picture.height)
+        {
+            free(variant.subColorsMatrix);
+            orientObject(&object, 0, &variant);
+        }
+        int plantedRow = randomInt(0, picture.height - variant.height);
+        int plantedColumn = randomInt(0, picture.width - variant.width);
+        plantObject(&picture, &variant, plantedRow, plantedColumn, randomInt(0, 2));
+        double value = referenceMatchingValue(&picture, &variant, plantedRow, plantedColumn);
+        free(variant.subColorsMatrix);
+        int hasReciprocals = pictureReciprocals(&picture, reciprocals);
+
+        double thresholds[] = {value, nextafter(value, INFINITY), nextafter(value, -INFINITY), (double)rand() / RAND_MAX};
+        for (int t = 0; t < 4; t++)
+        {
+            int expected = NOT_FOUND, expectedOrientation = 0;
+            for (int o = 0; o < NUMBER_OF_ORIENTATIONS; o++)
+            {
+                orientObject(&object, o, &variant);
+                int upperLeftCorner = referenceFirstMatch(&picture, &variant, thresholds[t]);
+                if (upperLeftCorner != NOT_FOUND && (expected == NOT_FOUND || upperLeftCorner < expected))
+                {
+                    expected = upperLeftCorner;
+                    expectedOrientation = o;
+                }
+                free(variant.subColorsMatrix);
+            }
+
+            for (int r = 0; r < 2; r++)
+            {
+                const char *method = r == 0 && hasReciprocals ? "orientations with reciprocals" : "orientations without reciprocals";
+                int upperLeftCorner = NOT_FOUND, orientation = 0;
+                calculateMatchingOrientations(&picture, r == 0 && hasReciprocals ? reciprocals : NULL, oriented, &upperLeftCorner, &orientation, thresholds[t]);
+                compareFirstMatch(options, stats, method, "orientation planted", &picture, &object, thresholds[t], expected, upperLeftCorner);
+
+                // the orientation is checked on its own once the position matches
+                if (upperLeftCorner != expected || expected == NOT_FOUND)
+                    continue;
+                stats->numberOfChecks++;
+                if (orientation == expectedOrientation)
+                    continue;
+                stats->numberOfMismatches++;
+                printf("MISMATCH %s, picture %d (%dx%d), object %d (%dx%d) with %d distinct orientations, threshold %.17g: "
+                       "reference orientation %d, found orientation %d\n", method, picture.ID, picture.width, picture.height,
+                       object.ID, object.width, object.height, oriented->numberOfVariants, thresholds[t], expectedOrientation, orientation);
+            }
+        }
+        freeOrientedObjects(oriented, 1);
+        freeCase(&picture, &object);
+    }
+    free(reciprocals);
+}
+
+/*
+ * This function searches a masked object with findMaskedObjects and compares the first match with the masked reference,
+ * and the score of the log with the reference value averaged over the active members
+ * @return: the score of the match, or NAN if there is none
+ */
+static double checkMaskedCase(VerifyOptions *options, VerifyStats *stats, const char *description, Picture *picture, Object *object,
+                              MaskedObject *masked, Logs *log, int transparentColor, double matchingThreshold)
+{
+    log->numObjectsFound = 0;
+    findMaskedObjects(picture, masked, log, 1, matchingThreshold, 1);
+    int upperLeftCorner = log->numObjectsFound > 0 ? log->objectPositions[0].row * picture->width + log->objectPositions[0].column : NOT_FOUND;
+    int expected = referenceMaskedFirstMatch(picture, object, transparentColor, matchingThreshold);
+    compareFirstMatch(options, stats, "masked search", description, picture, object, matchingThreshold, expected, upperLeftCorner);
+    if (upperLeftCorner == NOT_FOUND || upperLeftCorner != expected)
+        return NAN;
+
+    double value = referenceMaskedValue(picture, object, transparentColor, log->objectPositions[0].row, log->objectPositions[0].column);
+    stats->numberOfChecks++;
+    if (log->objectScores[0] != value)
+    {
+        stats->numberOfMismatches++;
+        printf("MISMATCH masked score, %s, picture %d (%dx%d), object %d (%dx%d) with %d active members, threshold %.17g: reference %.17g, found %.17g\n",
+               description, picture->ID, picture->width, picture->height, object->ID, object->width, object->height, masked->numberOfActive,
+               matchingThreshold, value, log->objectScores[0]);
+    }
+    return log->objectScores[0];
+}
+
+/*
+ * The masked search against the masked reference. The objects take turns having some transparent members, only
+ * transparent members and no transparent members. The thresholds are the planted value with one ulp around it,
+ * random ones, and the score found at a random threshold with one ulp above it.
+ */
+static void verifyMaskedCases(VerifyOptions *options, VerifyStats *stats)
+{
+    const char *descriptions[NUM_MASK_KINDS] = {"some transparent members", "fully transparent object", "no transparent members"};
+    Picture picture;
+    Object object;
+    Logs *log = (Logs *)malloc(sizeof(Logs));
+    if (log == NULL)
+        fail("allocating memory for", "log");
+    allocateLogArrays(log, 1, NULL);
+
+    for (int c = 0; c < options->numberOfCases; c++)
+    {
+        int kind = c % NUM_MASK_KINDS;
+        int plantedRow, plantedColumn;
+        generateRandomCase(&picture, &object, &plantedRow, &plantedColumn);
+
+        // object colors are 1 to 100, so 0 is never transparent
+        int transparentColor = kind == 2 ? 0 : randomInt(1, 100);
+        int transparentPercent = kind == 1 ? 100 : kind == 0 ? randomInt(10, 70) : 0;
+        for (int i = 0; i < object.height; i++)
+            for (int j = 0; j < object.width; j++)
+                if (rand() % 100 < transparentPercent)
+                    object.subColorsMatrix[i * object.pitch + j] = transparentColor;
+        MaskedObject masked;
+        maskObject(&object, transparentColor, &masked);
+
+        double thresholds[MAX_MASK_THRESHOLDS];
+        int numberOfThresholds = 0;
+        thresholds[numberOfThresholds++] = (double)rand() / RAND_MAX;
+        thresholds[numberOfThresholds++] = rand() % 2 ? 1.0 : INFINITY;
+        if (masked.numberOfActive > 0)
+        {
+            double value = referenceMaskedValue(&picture, &object, transparentColor, plantedRow, plantedColumn);
+            thresholds[numberOfThresholds++] = value;
+            thresholds[numberOfThresholds++] = nextafter(value, INFINITY);
+            thresholds[numberOfThresholds++] = nextafter(value, -INFINITY);
+        }
+
+        for (int t = 0; t < numberOfThresholds; t++)
+        {
+            double score = checkMaskedCase(options, stats, descriptions[kind], &picture, &object, &masked, log, transparentColor, thresholds[t]);
+            // a threshold equal to a found score must not match at that position, one ulp above it must
+            if (t == 0 && !isnan(score))
+            {
+                checkMaskedCase(options, stats, descriptions[kind], &picture, &object, &masked, log, transparentColor, score);
+                checkMaskedCase(options, stats, descriptions[kind], &picture, &object, &masked, log, transparentColor, nextafter(score, INFINITY));
+            }
+        }
+        free(masked.runs);
+        free(masked.colors);
+        freeCase(&picture, &object);
+    }
+    freeLogs(log, 1);
+}
+
+static void verifyAdversarialCases(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture picture;
+    Object object;
+
+    for (int c = 0; c < NUM_ADVERSARIAL_CASES; c++)
+    {
+        const char *description;
+        switch (c)
+        {
+        case 0:
+            // every picture color is 0, so every position has value 0
+            description = "all zero picture";
+            allocateCase(&picture, &object, 17, 5);
+            memset(picture.colorsMatrix, 0, 17 * 17 * sizeof(int));
+            for (int i = 0; i < 25; i++)
+                object.subColorsMatrix[i] = randomInt(1, 100);
+            break;
+        case 1:
+            description = "object as large as the picture";
+            allocateCase(&picture, &object, 13, 13);
+            for (int i = 0; i < 169; i++)
+                picture.colorsMatrix[i] = object.subColorsMatrix[i] = randomInt(1, 100);
+            break;
+        case 2:
+            description = "single member object";
+            allocateCase(&picture, &object, 23, 1);
+            for (int i = 0; i < 23 * 23; i++)
+                picture.colorsMatrix[i] = randomInt(1, 100);
+            object.subColorsMatrix[0] = picture.colorsMatrix[22 * 23 + 22];
+            break;
+        case 3:
+            // the largest possible differences
+            description = "maximal value";
+            allocateCase(&picture, &object, 19, 7);
+            for (int i = 0; i < 19 * 19; i++)
+                picture.colorsMatrix[i] = 1;
+            for (int i = 0; i < 49; i++)
+                object.subColorsMatrix[i] = 100;
+            break;
+        case 4:
+            description = "only the last position matches";
+            allocateCase(&picture, &object, 21, 6);
+            for (int i = 0; i < 21 * 21; i++)
+                picture.colorsMatrix[i] = 100;
+            for (int i = 0; i < 36; i++)
+                object.subColorsMatrix[i] = 1;
+            for (int i = 0; i < 6; i++)
+                for (int j = 0; j < 6; j++)
+                    picture.colorsMatrix[(15 + i) * 21 + 15 + j] = 1;
+            break;
+        default:
+            // identical rows, so neighbouring positions have nearly equal values
+            description = "repeated rows";
+            allocateCase(&picture, &object, 40, 9);
+            for (int j = 0; j < 40; j++)
+                picture.colorsMatrix[j] = randomInt(1, 100);
+            for (int i = 1; i < 40; i++)
+                memcpy(picture.colorsMatrix + i * 40, picture.colorsMatrix, 40 * sizeof(int));
+            for (int i = 0; i < 81; i++)
+                object.subColorsMatrix[i] = randomInt(1, 100);
+            break;
+        }
+
+        checkCase(options, stats, description, &picture, &object, 0.0);
+        checkCase(options, stats, description, &picture, &object, 0.1);
+        checkCase(options, stats, description, &picture, &object, 1.0);
+        double value = referenceMatchingValue(&picture, &object, 0, 0);
+        checkCase(options, stats, description, &picture, &object, value);
+        checkCase(options, stats, description, &picture, &object, nextafter(value, INFINITY));
+        freeCase(&picture, &object);
+    }
+}
+
+static void verifyInputFile(VerifyOptions *options, VerifyStats *stats)
+{
+    Picture *pictures;
+    Object *objects;
+    double matchingThreshold;
+    int numberOfPictures, numberOfObjects;
+
+    readInputFile(options->inputFile, &pictures, &objects, &matchingThreshold, &numberOfPictures, &numberOfObjects);
+    for (int p = 0; p < numberOfPictures; p++)
+        for (int o = 0; o < numberOfObjects; o++)
+            if (objects[o].width <= pictures[p].width && objects[o].height <= pictures[p].height)
+                checkCase(options, stats, options->inputFile, &pictures[p], &objects[o], matchingThreshold);
+    freePictures(pictures, numberOfPictures);
+    freeObjects(objects, numberOfObjects);
+}
+
+int main(int argc, char *argv[])
+{
+    VerifyOptions options;
+    VerifyStats stats = {0, 0};
+
+    // readInputFile reports errors through MPI
+    MPI_Init(&argc, &argv);
+    parseVerifyOptions(argc, argv, &options);
+    srand(options.seed);
+
+    if (options.inputFile != NULL)
+        verifyInputFile(&options, &stats);
+    else
+    {
+        verifyAdversarialCases(&options, &stats);
+        verifyRandomCases(&options, &stats);
+        verifyThresholdCases(&options, &stats);
+        verifyRecordLowCases(&options, &stats);
+        verifyStripCases(&options, &stats);
+        verifyOrientationCases(&options, &stats);
+        verifyMaskedCases(&options, &stats);
+    }
+
+    printf("%ld checks, %ld mismatches against the reference\n", stats.numberOfChecks, stats.numberOfMismatches);
+    MPI_Finalize();
+    return stats.numberOfMismatches == 0 ? 0 : 1;
+}